@@ -0,0 +1,178 @@
+#include "binary_protocol.h"
+
+#include <sstream>
+#include <variant>
+
+using namespace std::literals;
+using namespace binary;
+
+
+std::string binary::EncodeRequest(const Request& request) {
+    std::string payload;
+    Writer writer(payload);
+    writer.WriteU8(static_cast<uint8_t>(request.type)).WriteI32(request.id);
+    switch (request.type) {
+        case RequestType::STOP:
+        case RequestType::BUS:
+            writer.WriteU32(request.object_id);
+            break;
+        case RequestType::ROUTE:
+            writer.WriteU32(request.object_id).WriteU32(request.to_stop_id);
+            break;
+        case RequestType::MAP:
+        case RequestType::NAMES:
+            break;
+    }
+    return payload;
+}
+
+Request binary::DecodeRequest(std::string_view payload) {
+    Reader reader(payload);
+    Request request;
+    const uint8_t type = reader.ReadU8();
+    if (type < static_cast<uint8_t>(RequestType::STOP) || type > static_cast<uint8_t>(RequestType::NAMES)) {
+        throw std::invalid_argument("Unknown binary request type"s);
+    }
+    request.type = static_cast<RequestType>(type);
+    request.id = reader.ReadI32();
+    if (request.type == RequestType::STOP || request.type == RequestType::BUS) {
+        request.object_id = reader.ReadU32();
+    }
+    else if (request.type == RequestType::ROUTE) {
+        request.object_id = reader.ReadU32();
+        request.to_stop_id = reader.ReadU32();
+    }
+    if (!reader.IsEnd()) {
+        throw std::invalid_argument("Extra data in binary request"s);
+    }
+    return request;
+}
+
+
+// Начинает ответ: тип, номер запроса и статус
+static void WriteResponseHeader(Writer& writer, RequestType type, int request_id, ResponseStatus status) {
+    writer.WriteU8(static_cast<uint8_t>(type)).WriteI32(request_id).WriteU8(static_cast<uint8_t>(status));
+}
+
+// Дописывает тело ответа на запрос Stop, false - остановка не найдена
+static bool WriteStopResponse(Writer& writer, const RequestHandler& request_handler, const Request& request) {
+    const std::optional<domain::StopInfo> stop_info = request_handler.GetBusesByStopId(request.object_id);
+    if (!stop_info) {
+        return false;
+    }
+    writer.WriteU32(static_cast<uint32_t>(stop_info->buses_ids.size()));
+    for (domain::BusId bus_id : stop_info->buses_ids) {
+        writer.WriteU32(bus_id);
+    }
+    return true;
+}
+
+// Дописывает тело ответа на запрос Bus, false - маршрут не найден
+static bool WriteBusResponse(Writer& writer, const RequestHandler& request_handler, const Request& request) {
+    const std::optional<domain::BusInfo> bus_info = request_handler.GetBusStatById(request.object_id);
+    if (!bus_info) {
+        return false;
+    }
+    writer.WriteDouble(bus_info->roads_route_length)
+          .WriteDouble(bus_info->roads_route_length / bus_info->geo_route_length)
+          .WriteU32(static_cast<uint32_t>(bus_info->num_of_stops_on_route))
+          .WriteU32(static_cast<uint32_t>(bus_info->num_of_unique_stops));
+    return true;
+}
+
+// Дописывает тело ответа на запрос Route, false - маршрут не найден
+static bool WriteRouteResponse(Writer& writer, const RequestHandler& request_handler, const Request& request) {
+    using namespace routing;
+    const transport::TransportCatalogue& catalogue = request_handler.GetTransportCatalogue();
+    const domain::Stop* from_stop = catalogue.GetStopById(request.object_id);
+    const domain::Stop* to_stop = catalogue.GetStopById(request.to_stop_id);
+    if (!from_stop || !to_stop) {
+        return false;
+    }
+    const TransportRouteInfo route_info = request_handler.GetRoute(from_stop->name, to_stop->name);
+    if (!route_info) {
+        return false;
+    }
+
+    const TransportRouteItems& items = route_info->first;
+    writer.WriteDouble(route_info->second).WriteU32(static_cast<uint32_t>(items.size()));
+    for (const auto& item : items) {
+        if (const auto* wait_item = std::get_if<WaitRouteItem>(&item)) {
+            writer.WriteU8(static_cast<uint8_t>(RouteItemType::WAIT))
+                  .WriteU32(wait_item->stop_id)
+                  .WriteDouble(wait_item->duration);
+        }
+        else if (const auto* bus_item = std::get_if<BusRouteItem>(&item)) {
+            writer.WriteU8(static_cast<uint8_t>(RouteItemType::BUS))
+                  .WriteU32(bus_item->bus_id)
+                  .WriteU32(static_cast<uint32_t>(bus_item->span_count))
+                  .WriteDouble(bus_item->duration);
+        }
+        else {
+            throw std::invalid_argument("LOG err: in WriteRouteResponse - The item type in route is not Wait or Bus"s);
+        }
+    }
+    return true;
+}
+
+// Дописывает тело ответа на запрос Names: таблицы id и названий остановок и маршрутов
+static void WriteNamesResponse(Writer& writer, const RequestHandler& request_handler) {
+    const transport::TransportCatalogue& catalogue = request_handler.GetTransportCatalogue();
+    const std::vector<const domain::Stop*> stops = catalogue.GetAllStops();
+    writer.WriteU32(static_cast<uint32_t>(stops.size()));
+    for (const domain::Stop* stop : stops) {
+        writer.WriteU32(stop->id).WriteString(stop->name);
+    }
+    const auto buses = catalogue.GetAllBuses();
+    writer.WriteU32(static_cast<uint32_t>(buses.size()));
+    for (const auto& [bus_name, bus] : buses) {
+        writer.WriteU32(bus->id).WriteString(bus_name);
+    }
+}
+
+
+std::string binary::ProcessRequest(RequestHandler& request_handler, std::string_view payload) {
+    std::string response;
+    Writer writer(response);
+
+    Request request;
+    try {
+        request = DecodeRequest(payload);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "LOG err: in binary::ProcessRequest: "s << e.what() << std::endl;
+        const uint8_t type = payload.empty() ? 0 : static_cast<uint8_t>(payload[0]);
+        writer.WriteU8(type).WriteI32(0).WriteU8(static_cast<uint8_t>(ResponseStatus::BAD_REQUEST));
+        return response;
+    }
+
+    // статус становится известен только после поиска: пишем OK и исправляем, если не найдено
+    WriteResponseHeader(writer, request.type, request.id, ResponseStatus::OK);
+    const size_t header_size = response.size();
+    bool found = true;
+    switch (request.type) {
+        case RequestType::STOP:
+            found = WriteStopResponse(writer, request_handler, request);
+            break;
+        case RequestType::BUS:
+            found = WriteBusResponse(writer, request_handler, request);
+            break;
+        case RequestType::ROUTE:
+            found = WriteRouteResponse(writer, request_handler, request);
+            break;
+        case RequestType::MAP: {
+            std::ostringstream svg_stream;
+            request_handler.RenderMap(svg_stream);
+            writer.WriteString(svg_stream.str());
+            break;
+        }
+        case RequestType::NAMES:
+            WriteNamesResponse(writer, request_handler);
+            break;
+    }
+    if (!found) {
+        response.resize(header_size);
+        response.back() = static_cast<char>(ResponseStatus::NOT_FOUND);
+    }
+    return response;
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include "request_handler.h"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+/*
+ * Двоичный протокол запросов и ответов - альтернатива JSON для режима сервера.
+ *
+ * Сервер передает каждое сообщение кадром: длина содержимого (uint32) и само содержимое,
+ * здесь описано только содержимое. Все числа little-endian, вещественные - IEEE 754 double,
+ * строки - uint32 длина и байты. Остановки и маршруты передаются по id из каталога,
+ * таблицу названий клиент получает один раз запросом Names.
+ *
+ * Запрос: uint8 тип, int32 номер запроса, далее по типу:
+ *   Stop  - uint32 id остановки
+ *   Bus   - uint32 id маршрута
+ *   Route - uint32 id остановки отправления, uint32 id остановки назначения
+ *   Map, Names - ничего
+ *
+ * Ответ: uint8 тип, int32 номер запроса, uint8 статус, при статусе OK далее по типу:
+ *   Stop  - uint32 число маршрутов, id маршрутов в порядке их названий
+ *   Bus   - double длина, double извилистость, uint32 число остановок, uint32 число уникальных остановок
+ *   Route - double полное время, uint32 число шагов, шаги:
+ *           uint8 Wait, uint32 id остановки, double время ожидания или
+ *           uint8 Bus, uint32 id маршрута, uint32 число пролетов, double время в пути
+ *   Map   - строка с svg-документом
+ *   Names - uint32 число остановок, пары (uint32 id, строка название), то же для маршрутов
+ */
+
+namespace binary {
+
+enum class RequestType : uint8_t {
+    STOP = 1,
+    BUS = 2,
+    ROUTE = 3,
+    MAP = 4,
+    NAMES = 5,
+};
+
+enum class ResponseStatus : uint8_t {
+    OK = 0,
+    NOT_FOUND = 1,
+    BAD_REQUEST = 2,
+};
+
+enum class RouteItemType : uint8_t {
+    WAIT = 0,
+    BUS = 1,
+};
+
+
+// Дописывает значения в формате протокола в конец строки
+class Writer {
+public:
+    explicit Writer(std::string& output)
+        : output_(output) {
+    }
+
+    Writer& WriteU8(uint8_t value) {
+        output_.push_back(static_cast<char>(value));
+        return *this;
+    }
+
+    Writer& WriteU32(uint32_t value) {
+        char bytes[4];
+        for (int i = 0; i < 4; ++i) {
+            bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+        }
+        output_.append(bytes, 4);
+        return *this;
+    }
+
+    Writer& WriteI32(int32_t value) {
+        return WriteU32(static_cast<uint32_t>(value));
+    }
+
+    Writer& WriteDouble(double value) {
+        uint64_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(bits));
+        char bytes[8];
+        for (int i = 0; i < 8; ++i) {
+            bytes[i] = static_cast<char>((bits >> (8 * i)) & 0xFF);
+        }
+        output_.append(bytes, 8);
+        return *this;
+    }
+
+    Writer& WriteString(std::string_view value) {
+        WriteU32(static_cast<uint32_t>(value.size()));
+        output_.append(value.data(), value.size());
+        return *this;
+    }
+
+private:
+    std::string& output_;
+};
+
+
+// Читает значения в формате протокола, при нехватке данных выбрасывает исключение invalid_argument
+class Reader {
+public:
+    explicit Reader(std::string_view input)
+        : input_(input) {
+    }
+
+    uint8_t ReadU8() {
+        return static_cast<uint8_t>(Take(1)[0]);
+    }
+
+    uint32_t ReadU32() {
+        const std::string_view bytes = Take(4);
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) {
+            value |= static_cast<uint32_t>(static_cast<uint8_t>(bytes[i])) << (8 * i);
+        }
+        return value;
+    }
+
+    int32_t ReadI32() {
+        return static_cast<int32_t>(ReadU32());
+    }
+
+    double ReadDouble() {
+        const std::string_view bytes = Take(8);
+        uint64_t bits = 0;
+        for (int i = 0; i < 8; ++i) {
+            bits |= static_cast<uint64_t>(static_cast<uint8_t>(bytes[i])) << (8 * i);
+        }
+        double value = 0;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    std::string_view ReadString() {
+        const uint32_t size = ReadU32();
+        return Take(size);
+    }
+
+    // Проверяет, что все данные прочитаны
+    bool IsEnd() const {
+        return input_.empty();
+    }
+
+private:
+    std::string_view input_;
+
+    std::string_view Take(size_t size) {
+        if (input_.size() < size) {
+            throw std::invalid_argument("Binary message is too short");
+        }
+        std::string_view result = input_.substr(0, size);
+        input_.remove_prefix(size);
+        return result;
+    }
+};
+
+
+// Запрос в двоичном протоколе: вместо названий - id из каталога
+struct Request {
+    RequestType type = RequestType::NAMES;
+    int id = 0;
+    uint32_t object_id = 0;     // id остановки (Stop, отправление для Route) или маршрута (Bus)
+    uint32_t to_stop_id = 0;    // остановка назначения для Route
+};
+
+// Кодирует запрос в содержимое кадра (для клиентов)
+std::string EncodeRequest(const Request& request);
+
+// Декодирует содержимое кадра с запросом, при ошибке формата выбрасывает исключение invalid_argument
+Request DecodeRequest(std::string_view payload);
+
+/*
+Обрабатывает один запрос и возвращает содержимое кадра с ответом.
+Запрос Route требует маршрутизатора в request_handler, ответ на неразобранный запрос - статус BAD_REQUEST.
+Можно вызывать из нескольких потоков
+*/
+std::string ProcessRequest(RequestHandler& request_handler, std::string_view payload);
+
+}  // namespace binary
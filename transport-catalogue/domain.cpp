@@ -39,12 +39,11 @@ bool domain::IsBus(const Bus* bus_to_check) {
 }
 
 
-double domain::ComputeGeoRouteLength(const Bus* bus) {
-    double route_length = 0;
-    for (size_t i = 1; i < bus->stops_on_route.size(); i++) {
-        route_length += geo::ComputeDistance(bus->stops_on_route[i]->coordinates, bus->stops_on_route[i-1]->coordinates);
+// Возвращает число остановок на маршруте с учетом обратного хода некольцевого маршрута
+size_t domain::GetRouteStopsCount(const Bus& bus) {
+    if (bus.is_round || bus.stops.empty()) {
+        return bus.stops.size();
     }
-    return route_length;
+    return 2 * bus.stops.size() - 1;
 }
 
-
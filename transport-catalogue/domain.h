@@ -12,8 +12,8 @@
  *
  */
 
+#include <cstdint>
 #include <string>
-#include <unordered_set>
 #include <vector>
 
 
@@ -21,17 +21,29 @@
 
 namespace domain {
 
+// Идентификатор остановки - её порядковый номер в каталоге
+using StopId = uint32_t;
+// Идентификатор маршрута - его порядковый номер в каталоге
+using BusId = uint32_t;
+
 struct Stop {
     std::string name;
     geo::Coordinates coordinates;
+    StopId id = 0;
 };
 
 
+/*
+Маршрут хранит каждую остановку один раз: для некольцевого маршрута - только прямой ход 
+от начальной до конечной остановки, обратный ход перебирается "виртуально" 
+(см. GetRouteStopsCount и GetRouteStopId)
+*/
 struct Bus {
     std::string name;
-    std::vector<const Stop*> stops_on_route;
-    std::unordered_set<std::string_view> unique_stops;
+    std::vector<StopId> stops;
     bool is_round;
+    uint32_t unique_stops_count = 0;
+    BusId id = 0;
 };
 
 
@@ -48,6 +60,7 @@ struct BusInfo {
 struct StopInfo {
     std::string name;
     std::vector<std::string_view> buses_list;
+    std::vector<BusId> buses_ids;  // id тех же маршрутов в том же порядке
 };
 
 using StopsPair = std::pair<const Stop*, const Stop*>;
@@ -80,7 +93,15 @@ bool IsStop(const Stop* stop_to_check);
 // проверяет, есть ли маршрут/инфа о маршруте по указателю
 bool IsBus(const Bus* bus_to_check);
 
-double ComputeGeoRouteLength(const Bus* bus);
+// Возвращает число остановок на маршруте с учетом обратного хода некольцевого маршрута
+size_t GetRouteStopsCount(const Bus& bus);
+
+// Возвращает id остановки с номером index на маршруте с учетом обратного хода,
+// index должен быть меньше GetRouteStopsCount(bus)
+inline StopId GetRouteStopId(const Bus& bus, size_t index) {
+    const size_t forward_count = bus.stops.size();
+    return index < forward_count ? bus.stops[index] : bus.stops[2 * forward_count - 2 - index];
+}
 
 
 } //namespace domain
@@ -2,6 +2,7 @@
 
 #include "ranges.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <vector>
 
@@ -33,6 +34,14 @@ public:
     explicit DirectedWeightedGraph(size_t vertex_count);
     EdgeId AddEdge(const Edge<Weight>& edge);
 
+    // Добавляет вершину без ребер и возвращает её номер
+    VertexId AddVertex();
+    // Меняет вес существующего ребра
+    void SetEdgeWeight(EdgeId edge_id, const Weight& weight);
+    // Удаляет ребро из списка исходящих ребер вершины. 
+    // Номер ребра остается занятым, чтобы номера остальных ребер не менялись
+    void RemoveEdge(EdgeId edge_id);
+
     size_t GetVertexCount() const;
     size_t GetEdgeCount() const;
     const Edge<Weight>& GetEdge(EdgeId edge_id) const;
@@ -58,6 +67,26 @@ EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
     return id;
 }
 
+template <typename Weight>
+VertexId DirectedWeightedGraph<Weight>::AddVertex() {
+    incidence_lists_.emplace_back();
+    return incidence_lists_.size() - 1;
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::SetEdgeWeight(EdgeId edge_id, const Weight& weight) {
+    edges_.at(edge_id).weight = weight;
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::RemoveEdge(EdgeId edge_id) {
+    IncidenceList& incidence_list = incidence_lists_.at(edges_.at(edge_id).from);
+    const auto it = std::find(incidence_list.begin(), incidence_list.end(), edge_id);
+    if (it != incidence_list.end()) {
+        incidence_list.erase(it);
+    }
+}
+
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
     return incidence_lists_.size();
@@ -1,354 +1,909 @@
 #include "json.h"
-
-#include <iterator>
+#include "json_scanner.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace json {
 
 namespace {
 using namespace std::literals;
 
-Node LoadNode(std::istream& input);
-Node LoadString(std::istream& input);
+// С какого размера буфера разбор идет по структурным позициям (json_scanner.h).
+// Большую часть времени разбора занимает построение дерева, поэтому на небольших документах
+// и строках запросов сервера отдельный проход сканера не окупается
+constexpr size_t MIN_SIZE_FOR_INDEX = 1024 * 1024;
 
-std::string LoadLiteral(std::istream& input) {
-    std::string s;
-    while (std::isalpha(input.peek())) {
-        s.push_back(static_cast<char>(input.get()));
-    }
-    return s;
+// Пробельные символы JSON и те, что пропускает operator>> в локали "C"
+inline bool IsSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+}
+
+inline bool IsDigit(char c) {
+    return c >= '0' && c <= '9';
 }
 
-Node LoadArray(std::istream& input) {
-    std::vector<Node> result;
+inline bool IsAlpha(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+/*
+Разбирает JSON из непрерывного буфера [begin, end), двигаясь по нему указателем,
+и сообщает о прочитанных значениях обработчику событий EventHandler.
+Правила разбора и сообщения об ошибках совпадают с прежним посимвольным чтением из потока.
+
+Если передан сканер структурных позиций буфера, пробелы и строки без экранирования
+пропускаются переходом к следующей структурной позиции. Пока разбор не встретил ошибку,
+его границы строк совпадают с найденными сканером
+*/
+template <typename EventHandler>
+class Parser {
+public:
+    Parser(const char* begin, const char* end, EventHandler& handler)
+        : begin_(begin)
+        , pos_(begin)
+        , end_(end)
+        , handler_(handler) {
+    }
+
+    Parser(const char* begin, const char* end, json_scan::StructuralScanner& scanner, EventHandler& handler)
+        : begin_(begin)
+        , pos_(begin)
+        , end_(end)
+        , handler_(handler)
+        , scanner_(&scanner) {
+    }
 
-    for (char c; input >> c && c != ']';) {
-        if (c != ',') {
-            input.putback(c);
+    void ParseNode() {
+        char c;
+        if (!ReadChar(c)) {
+            throw ParsingError("Unexpected EOF"s);
+        }
+        switch (c) {
+            case '[':
+                ParseArray();
+                break;
+            case '{':
+                ParseDict();
+                break;
+            case '"':
+                handler_.String(ReadString());
+                break;
+            case 't':
+                // встретив t или f, переходим к попытке парсинга литералов true либо false
+                [[fallthrough]];
+            case 'f':
+                --pos_;
+                ParseBool();
+                break;
+            case 'n':
+                --pos_;
+                ParseNull();
+                break;
+            default:
+                --pos_;
+                ParseNumber();
+                break;
         }
-        result.push_back(LoadNode(input));
     }
-    if (!input) {
-        throw ParsingError("Array parsing error"s);
+
+private:
+    const char* begin_;
+    const char* pos_;
+    const char* end_;
+    EventHandler& handler_;
+    // раскодированная строка с экранированием (остальные строки - части буфера)
+    std::string unescaped_;
+    // сканер структурных позиций и еще не пройденная часть его текущей порции
+    json_scan::StructuralScanner* scanner_ = nullptr;
+    const uint32_t* index_pos_ = nullptr;
+    const uint32_t* index_end_ = nullptr;
+
+    // Возвращает первую структурную позицию не раньше текущей или end_
+    const char* NextIndexed() {
+        while (true) {
+            while (index_pos_ != index_end_ && begin_ + *index_pos_ < pos_) {
+                ++index_pos_;
+            }
+            if (index_pos_ != index_end_) {
+                return begin_ + *index_pos_;
+            }
+            if (!scanner_->ScanNextChunk()) {
+                return end_;
+            }
+            index_pos_ = scanner_->begin();
+            index_end_ = scanner_->end();
+        }
     }
-    return Node(std::move(result));
-}
 
-Node LoadDict(std::istream& input) {
-    Dict dict;
+    void SkipSpaces() {
+        if (pos_ == end_ || !IsSpace(*pos_)) {
+            return;
+        }
+        if (scanner_) {
+            // после пробела вне строки первый непробельный символ всегда есть в индексе
+            pos_ = NextIndexed();
+            return;
+        }
+        while (pos_ != end_ && IsSpace(*pos_)) {
+            ++pos_;
+        }
+    }
 
-    for (char c; input >> c && c != '}';) {
-        if (c == '"') {
-            std::string key = LoadString(input).AsString();
-            if (input >> c && c == ':') {
-                if (dict.find(key) != dict.end()) {
-                    throw ParsingError("Duplicate key '"s + key + "' have been found");
+    // Пропускает пробельные символы и читает следующий символ, false - данные закончились
+    bool ReadChar(char& c) {
+        SkipSpaces();
+        if (pos_ == end_) {
+            return false;
+        }
+        c = *pos_++;
+        return true;
+    }
+
+    bool NextIs(char c) const {
+        return pos_ != end_ && *pos_ == c;
+    }
+
+    bool NextIsDigit() const {
+        return pos_ != end_ && IsDigit(*pos_);
+    }
+
+    std::string_view ReadLiteral() {
+        const char* begin = pos_;
+        while (pos_ != end_ && IsAlpha(*pos_)) {
+            ++pos_;
+        }
+        return {begin, static_cast<size_t>(pos_ - begin)};
+    }
+
+    void ParseArray() {
+        handler_.StartArray();
+        for (char c; ; ) {
+            if (!ReadChar(c)) {
+                throw ParsingError("Array parsing error"s);
+            }
+            if (c == ']') {
+                break;
+            }
+            if (c != ',') {
+                --pos_;
+            }
+            ParseNode();
+        }
+        handler_.EndArray();
+    }
+
+    void ParseDict() {
+        handler_.StartDict();
+        for (char c; ; ) {
+            if (!ReadChar(c)) {
+                throw ParsingError("Dictionary parsing error"s);
+            }
+            if (c == '}') {
+                break;
+            }
+            if (c == '"') {
+                const std::string_view key = ReadString();
+                if (ReadChar(c) && c == ':') {
+                    handler_.Key(key);
+                    ParseNode();
+                } else {
+                    throw ParsingError(": is expected but '"s + c + "' has been found"s);
                 }
-                dict.emplace(std::move(key), LoadNode(input));
-            } else {
-                throw ParsingError(": is expected but '"s + c + "' has been found"s);
+            } else if (c != ',') {
+                throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
             }
-        } else if (c != ',') {
-            throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
         }
+        handler_.EndDict();
     }
-    if (!input) {
-        throw ParsingError("Dictionary parsing error"s);
+
+    // Пропускает символы строки до кавычки, обратного слэша или перевода строки
+    void SkipPlainChars() {
+        while (pos_ != end_ && *pos_ != '"' && *pos_ != '\\' && *pos_ != '\n' && *pos_ != '\r') {
+            ++pos_;
+        }
     }
-    return Node(std::move(dict));
-}
 
-Node LoadString(std::istream& input) {
-    auto it = std::istreambuf_iterator<char>(input);
-    auto end = std::istreambuf_iterator<char>();
-    std::string s;
-    while (true) {
-        if (it == end) {
-            throw ParsingError("String parsing error");
+    /*
+    Читает строку после открывающей кавычки. Строка без экранирования возвращается
+    как часть буфера, иначе раскодированная строка собирается в unescaped_
+    и действительна до чтения следующей строки
+    */
+    std::string_view ReadString() {
+        const char* begin = pos_;
+        if (scanner_) {
+            // внутри строки в индексе есть кавычки, слэши и переводы строк:
+            // если следующая позиция - закрывающая кавычка, строка не содержит экранирования
+            if (const char* next = NextIndexed(); next != end_ && *next == '"') {
+                pos_ = next + 1;
+                return {begin, static_cast<size_t>(next - begin)};
+            }
+        }
+        SkipPlainChars();
+        if (pos_ != end_ && *pos_ == '"') {
+            ++pos_;
+            return {begin, static_cast<size_t>(pos_ - 1 - begin)};
         }
-        const char ch = *it;
-        if (ch == '"') {
-            ++it;
-            break;
-        } else if (ch == '\\') {
-            ++it;
-            if (it == end) {
+
+        unescaped_.assign(begin, pos_);
+        while (true) {
+            if (pos_ == end_) {
                 throw ParsingError("String parsing error");
             }
-            const char escaped_char = *(it);
-            switch (escaped_char) {
-                case 'n':
-                    s.push_back('\n');
-                    break;
-                case 't':
-                    s.push_back('\t');
-                    break;
-                case 'r':
-                    s.push_back('\r');
-                    break;
-                case '"':
-                    s.push_back('"');
-                    break;
-                case '\\':
-                    s.push_back('\\');
-                    break;
-                default:
-                    throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+            const char ch = *pos_++;
+            if (ch == '"') {
+                break;
+            } else if (ch == '\\') {
+                if (pos_ == end_) {
+                    throw ParsingError("String parsing error");
+                }
+                const char escaped_char = *pos_++;
+                switch (escaped_char) {
+                    case 'n':
+                        unescaped_.push_back('\n');
+                        break;
+                    case 't':
+                        unescaped_.push_back('\t');
+                        break;
+                    case 'r':
+                        unescaped_.push_back('\r');
+                        break;
+                    case '"':
+                        unescaped_.push_back('"');
+                        break;
+                    case '\\':
+                        unescaped_.push_back('\\');
+                        break;
+                    default:
+                        throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+                }
+            } else {
+                throw ParsingError("Unexpected end of line"s);
             }
-        } else if (ch == '\n' || ch == '\r') {
-            throw ParsingError("Unexpected end of line"s);
+            const char* chunk_begin = pos_;
+            SkipPlainChars();
+            unescaped_.append(chunk_begin, pos_);
+        }
+        return unescaped_;
+    }
+
+    void ParseBool() {
+        const std::string_view s = ReadLiteral();
+        if (s == "true"sv) {
+            handler_.Bool(true);
+        } else if (s == "false"sv) {
+            handler_.Bool(false);
+        } else {
+            throw ParsingError("Failed to parse '"s + std::string(s) + "' as bool"s);
+        }
+    }
+
+    void ParseNull() {
+        if (const std::string_view literal = ReadLiteral(); literal == "null"sv) {
+            handler_.Null();
         } else {
-            s.push_back(ch);
+            throw ParsingError("Failed to parse '"s + std::string(literal) + "' as null"s);
         }
-        ++it;
     }
 
-    return Node(std::move(s));
+    // Пропускает одну или более цифр
+    void SkipDigits() {
+        if (!NextIsDigit()) {
+            throw ParsingError("A digit is expected"s);
+        }
+        while (NextIsDigit()) {
+            ++pos_;
+        }
+    }
+
+    void ParseNumber() {
+        const char* begin = pos_;
+        if (NextIs('-')) {
+            ++pos_;
+        }
+        // Парсим целую часть числа
+        if (NextIs('0')) {
+            ++pos_;
+            // После 0 в JSON не могут идти другие цифры
+        } else {
+            SkipDigits();
+        }
+
+        bool is_int = true;
+        // Парсим дробную часть числа
+        if (NextIs('.')) {
+            ++pos_;
+            SkipDigits();
+            is_int = false;
+        }
+
+        // Парсим экспоненциальную часть числа
+        if (NextIs('e') || NextIs('E')) {
+            ++pos_;
+            if (NextIs('+') || NextIs('-')) {
+                ++pos_;
+            }
+            SkipDigits();
+            is_int = false;
+        }
+
+        // число преобразуется на месте, без копирования и исключений
+        if (is_int) {
+            int value = 0;
+            if (std::from_chars(begin, pos_, value).ec == std::errc()) {
+                handler_.Int(value);
+                return;
+            }
+            // при переполнении int код ниже преобразует число в double
+        }
+        double value = 0;
+        const std::errc error = std::from_chars(begin, pos_, value).ec;
+        // прежний разбор через std::stod считал ошибкой и денормализованные значения (strtod сообщает о них ERANGE)
+        if (error != std::errc() || std::fpclassify(value) == FP_SUBNORMAL) {
+            throw ParsingError("Failed to convert "s + std::string(begin, pos_) + " to number"s);
+        }
+        handler_.Double(value);
+    }
+};
+
+// Разбирает буфер, для больших буферов - по структурным позициям
+template <typename EventHandler>
+void ParseBuffer(std::string_view input, EventHandler& handler) {
+    const char* begin = input.data();
+    const char* end = begin + input.size();
+    if (input.size() < MIN_SIZE_FOR_INDEX || input.size() >= std::numeric_limits<uint32_t>::max()) {
+        Parser<EventHandler>(begin, end, handler).ParseNode();
+        return;
+    }
+    json_scan::StructuralScanner scanner(input);
+    Parser<EventHandler>(begin, end, scanner, handler).ParseNode();
 }
 
-Node LoadBool(std::istream& input) {
-    const auto s = LoadLiteral(input);
-    if (s == "true"sv) {
-        return Node{true};
-    } else if (s == "false"sv) {
-        return Node{false};
-    } else {
-        throw ParsingError("Failed to parse '"s + s + "' as bool"s);
+}  // namespace
+
+std::string ReadAll(std::istream& input) {
+    std::string buffer;
+    char chunk[64 * 1024];
+    while (input.read(chunk, sizeof(chunk)) || input.gcount() > 0) {
+        buffer.append(chunk, static_cast<size_t>(input.gcount()));
     }
+    return buffer;
 }
 
-Node LoadNull(std::istream& input) {
-    if (auto literal = LoadLiteral(input); literal == "null"sv) {
-        return Node{nullptr};
-    } else {
-        throw ParsingError("Failed to parse '"s + literal + "' as null"s);
+std::string ReadValue(std::istream& input) {
+    std::streambuf& buffer = *input.rdbuf();
+    using Traits = std::streambuf::traits_type;
+    std::string value;
+    int depth = 0;
+    bool in_string = false;
+    for (Traits::int_type symbol = buffer.sbumpc(); symbol != Traits::eof(); symbol = buffer.sbumpc()) {
+        const char c = Traits::to_char_type(symbol);
+        if (value.empty() && IsSpace(c)) {
+            continue;
+        }
+        if (!in_string && depth == 0 && !value.empty() && IsSpace(c)) {
+            // простое значение закончилось
+            return value;
+        }
+        value.push_back(c);
+        if (in_string) {
+            if (c == '\\') {
+                symbol = buffer.sbumpc();
+                if (symbol == Traits::eof()) {
+                    break;
+                }
+                value.push_back(Traits::to_char_type(symbol));
+            }
+            else if (c == '"') {
+                in_string = false;
+            }
+            continue;
+        }
+        switch (c) {
+            case '"':
+                in_string = true;
+                break;
+            case '[':
+            case '{':
+                ++depth;
+                break;
+            case ']':
+            case '}':
+                if (--depth <= 0) {
+                    return value;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    if (value.empty() || in_string || depth > 0) {
+        input.setstate(std::ios::eofbit);
+        throw ParsingError("Unexpected end of input while reading a value"s);
     }
+    return value;
 }
 
-Node LoadNumber(std::istream& input) {
-    std::string parsed_num;
+FileContents ReadFileContents(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Can not open file "s + path);
+    }
+    struct stat file_stat{};
+    if (::fstat(fd, &file_stat) < 0 || file_stat.st_size == 0) {
+        ::close(fd);
+        return {};
+    }
+    const size_t size = static_cast<size_t>(file_stat.st_size);
+    void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        // например, для файлов, которые нельзя отобразить в память, - читаем обычным образом
+        std::ifstream file(path, std::ios::binary);
+        auto buffer = std::make_shared<const std::string>(ReadAll(file));
+        return {buffer, *buffer};
+    }
+    // файл читается подряд один раз
+    ::madvise(data, size, MADV_SEQUENTIAL);
+    // отображение снимается вместе с последней копией storage
+    std::shared_ptr<const void> mapping(data, [size](const void* ptr) {
+        ::munmap(const_cast<void*>(ptr), size);
+    });
+    return {std::move(mapping), std::string_view(static_cast<const char*>(data), size)};
+}
 
-    // Считывает в parsed_num очередной символ из input
-    auto read_char = [&parsed_num, &input] {
-        parsed_num += static_cast<char>(input.get());
-        if (!input) {
-            throw ParsingError("Failed to read number from stream"s);
-        }
-    };
+namespace {
 
-    // Считывает одну или более цифр в parsed_num из input
-    auto read_digits = [&input, read_char] {
-        if (!std::isdigit(input.peek())) {
-            throw ParsingError("A digit is expected"s);
+// Вызывает func(содержимое файла) для файла, отображенного в память, и возвращает ее результат.
+// Если файл не удалось открыть, выбрасывает исключение runtime_error
+template <typename Func>
+auto WithFileContents(const std::string& path, Func func) {
+    const FileContents file = ReadFileContents(path);
+    return func(file.contents);
+}
+
+/*
+Строит дерево документа-представления в арене. Значения копятся в общих стеках, и массив или словарь
+переносится в арену, когда закрывается, - так он занимает там ровно нужный участок.
+Строки, лежащие во входном буфере, не копируются
+*/
+class ViewTreeBuilder {
+public:
+    ViewTreeBuilder(std::string_view input, std::pmr::memory_resource& arena)
+        : input_(input)
+        , arena_(arena) {
+    }
+
+    void StartArray() {
+        frames_.push_back({values_.size(), keys_.size()});
+    }
+
+    void EndArray() {
+        const size_t begin = frames_.back().values_begin;
+        frames_.pop_back();
+        const size_t size = values_.size() - begin;
+        ViewNode* data = Allocate<ViewNode>(size);
+        std::uninitialized_move(values_.begin() + begin, values_.end(), data);
+        values_.erase(values_.begin() + begin, values_.end());
+        values_.emplace_back(ViewArray(data, size));
+    }
+
+    void StartDict() {
+        frames_.push_back({values_.size(), keys_.size()});
+    }
+
+    void EndDict() {
+        const Frame frame = frames_.back();
+        frames_.pop_back();
+        const size_t size = keys_.size() - frame.keys_begin;
+        ViewDict::value_type* items = Allocate<ViewDict::value_type>(size);
+        for (size_t i = 0; i < size; ++i) {
+            new (items + i) ViewDict::value_type(keys_[frame.keys_begin + i], std::move(values_[frame.values_begin + i]));
         }
-        while (std::isdigit(input.peek())) {
-            read_char();
+        keys_.erase(keys_.begin() + frame.keys_begin, keys_.end());
+        values_.erase(values_.begin() + frame.values_begin, values_.end());
+
+        std::sort(items, items + size, [](const auto& lhs, const auto& rhs) {
+            return lhs.first < rhs.first;
+        });
+        const auto duplicate = std::adjacent_find(items, items + size, [](const auto& lhs, const auto& rhs) {
+            return lhs.first == rhs.first;
+        });
+        if (duplicate != items + size) {
+            throw ParsingError("Duplicate key '"s + std::string(duplicate->first) + "' have been found");
         }
-    };
+        values_.emplace_back(ViewDict(items, size));
+    }
 
-    if (input.peek() == '-') {
-        read_char();
+    void Key(std::string_view key) {
+        keys_.push_back(Retain(key));
     }
-    // Парсим целую часть числа
-    if (input.peek() == '0') {
-        read_char();
-        // После 0 в JSON не могут идти другие цифры
-    } else {
-        read_digits();
+
+    void String(std::string_view value) {
+        values_.emplace_back(Retain(value));
+    }
+
+    void Int(int value) {
+        values_.emplace_back(value);
+    }
+
+    void Double(double value) {
+        values_.emplace_back(value);
+    }
+
+    void Bool(bool value) {
+        values_.emplace_back(value);
     }
 
-    bool is_int = true;
-    // Парсим дробную часть числа
-    if (input.peek() == '.') {
-        read_char();
-        read_digits();
-        is_int = false;
+    void Null() {
+        values_.emplace_back(nullptr);
     }
 
-    // Парсим экспоненциальную часть числа
-    if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-        read_char();
-        if (ch = input.peek(); ch == '+' || ch == '-') {
-            read_char();
+    ViewNode Extract() {
+        return std::move(values_.back());
+    }
+
+private:
+    struct Frame {
+        size_t values_begin;
+        size_t keys_begin;
+    };
+
+    std::string_view input_;
+    std::pmr::memory_resource& arena_;
+    std::vector<Frame> frames_;
+    std::vector<ViewNode> values_;
+    std::vector<std::string_view> keys_;
+
+    template <typename Value>
+    Value* Allocate(size_t count) {
+        return static_cast<Value*>(arena_.allocate(count * sizeof(Value), alignof(Value)));
+    }
+
+    // Парсер отдает строки без экранирования как части входного буфера, остальные копируются в арену
+    std::string_view Retain(std::string_view value) {
+        const std::less_equal<const char*> not_after;
+        if (not_after(input_.data(), value.data()) && not_after(value.data() + value.size(), input_.data() + input_.size())) {
+            return value;
         }
-        read_digits();
-        is_int = false;
+        char* data = Allocate<char>(value.size());
+        std::copy(value.begin(), value.end(), data);
+        return {data, value.size()};
     }
+};
 
-    try {
-        if (is_int) {
-            // Сначала пробуем преобразовать строку в int
-            try {
-                return std::stoi(parsed_num);
-            } catch (...) {
-                // В случае неудачи, например, при переполнении
-                // код ниже попробует преобразовать строку в double
+// Узлы не освобождаются по одному: арена документа освобождается целиком
+static_assert(std::is_trivially_destructible_v<ViewNode>);
+
+std::string_view TrimSpaces(std::string_view text) {
+    while (!text.empty() && IsSpace(text.front())) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && IsSpace(text.back())) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+/*
+Вызывает on_item(запись) для записей элементов контейнера text, который открывается символом open
+и закрывается символом close. Запятые и скобки ищутся только среди структурных позиций сканера,
+поэтому символы внутри строк границами не считаются
+*/
+template <typename Func>
+void SplitContainer(std::string_view text, char open, char close, Func on_item) {
+    text = TrimSpaces(text);
+    if (text.size() < 2 || text.front() != open || text.back() != close) {
+        throw ParsingError("Expected a container in "s + open + close);
+    }
+    if (text.size() >= std::numeric_limits<uint32_t>::max()) {
+        throw ParsingError("Container is too large to split"s);
+    }
+    json_scan::StructuralScanner scanner(text);
+    int depth = 0;
+    size_t item_begin = 1;
+    bool has_items = false;
+    auto add_item = [&](size_t item_end) {
+        const std::string_view item = TrimSpaces(text.substr(item_begin, item_end - item_begin));
+        // пустая запись - это пустой контейнер, а не пропущенный элемент
+        if (!item.empty() || has_items) {
+            on_item(item);
+            has_items = true;
+        }
+        item_begin = item_end + 1;
+    };
+    while (scanner.ScanNextChunk()) {
+        for (const uint32_t index : scanner) {
+            switch (text[index]) {
+                case '[':
+                case '{':
+                    ++depth;
+                    break;
+                case ']':
+                case '}':
+                    if (--depth == 0) {
+                        if (index + 1 != text.size()) {
+                            throw ParsingError("Unexpected symbols after the container"s);
+                        }
+                        add_item(index);
+                    }
+                    break;
+                case ',':
+                    if (depth == 1) {
+                        add_item(index);
+                    }
+                    break;
+                default:
+                    break;
             }
         }
-        return std::stod(parsed_num);
-    } catch (...) {
-        throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
+    }
+    if (depth != 0) {
+        throw ParsingError("Brackets are not balanced"s);
     }
 }
 
-Node LoadNode(std::istream& input) {
-    char c;
-    if (!(input >> c)) {
-        throw ParsingError("Unexpected EOF"s);
+}  // namespace
+
+void TreeBuilder::AddValue(Node value) {
+    if (frames_.empty()) {
+        root_ = std::move(value);
+        has_root_ = true;
+        return;
     }
-    switch (c) {
-        case '[':
-            return LoadArray(input);
-        case '{':
-            return LoadDict(input);
-        case '"':
-            return LoadString(input);
-        case 't':
-            // Атрибут [[fallthrough]] (провалиться) ничего не делает, и является
-            // подсказкой компилятору и человеку, что здесь программист явно задумывал
-            // разрешить переход к инструкции следующей ветки case, а не случайно забыл
-            // написать break, return или throw.
-            // В данном случае, встретив t или f, переходим к попытке парсинга
-            // литералов true либо false
-            [[fallthrough]];
-        case 'f':
-            input.putback(c);
-            return LoadBool(input);
-        case 'n':
-            input.putback(c);
-            return LoadNull(input);
-        default:
-            input.putback(c);
-            return LoadNumber(input);
+    Frame& frame = frames_.back();
+    if (Array* array = std::get_if<Array>(&frame.container.GetValue())) {
+        array->push_back(std::move(value));
+    } else {
+        std::get<Dict>(frame.container.GetValue()).emplace(std::move(frame.key), std::move(value));
     }
 }
 
-struct PrintContext {
-    std::ostream& out;
-    int indent_step = 4;
-    int indent = 0;
+void TreeBuilder::StartArray() {
+    frames_.push_back({Node(Array{}), {}});
+}
 
-    void PrintIndent() const {
-        for (int i = 0; i < indent; ++i) {
-            out.put(' ');
-        }
-    }
+void TreeBuilder::EndArray() {
+    Node array = std::move(frames_.back().container);
+    frames_.pop_back();
+    AddValue(std::move(array));
+}
 
-    PrintContext Indented() const {
-        return {out, indent_step, indent_step + indent};
+void TreeBuilder::StartDict() {
+    frames_.push_back({Node(Dict{}), {}});
+}
+
+void TreeBuilder::EndDict() {
+    Node dict = std::move(frames_.back().container);
+    frames_.pop_back();
+    AddValue(std::move(dict));
+}
+
+void TreeBuilder::Key(std::string_view key) {
+    Frame& frame = frames_.back();
+    frame.key = key;
+    const Dict& dict = std::get<Dict>(frame.container.GetValue());
+    if (dict.find(frame.key) != dict.end()) {
+        throw ParsingError("Duplicate key '"s + frame.key + "' have been found");
     }
-};
+}
+
+void TreeBuilder::String(std::string_view value) {
+    AddValue(Node(std::string(value)));
+}
 
-void PrintNode(const Node& value, const PrintContext& ctx);
+void TreeBuilder::Int(int value) {
+    AddValue(Node(value));
+}
 
-template <typename Value>
-void PrintValue(const Value& value, const PrintContext& ctx) {
-    ctx.out << value;
+void TreeBuilder::Double(double value) {
+    AddValue(Node(value));
 }
 
-void PrintString(const std::string& value, std::ostream& out) {
-    out.put('"');
-    for (const char c : value) {
-        switch (c) {
-            case '\r':
-                out << "\\r"sv;
-                break;
-            case '\n':
-                out << "\\n"sv;
-                break;
-            case '\t':
-                out << "\\t"sv;
-                break;
-            case '"':
-                // Символы " и \ выводятся как \" или \\, соответственно
-                [[fallthrough]];
-            case '\\':
-                out.put('\\');
-                [[fallthrough]];
-            default:
-                out.put(c);
-                break;
+void TreeBuilder::Bool(bool value) {
+    AddValue(Node(value));
+}
+
+void TreeBuilder::Null() {
+    AddValue(Node(nullptr));
+}
+
+
+Document Load(std::istream& input) {
+    return Load(std::string_view(ReadAll(input)));
+}
+
+Document Load(std::string_view input) {
+    TreeBuilder builder;
+    ParseBuffer(input, builder);
+    return Document{builder.Extract()};
+}
+
+Document LoadFile(const std::string& path) {
+    return WithFileContents(path, [](std::string_view contents) {
+        return Load(contents);
+    });
+}
+
+void Parse(std::string_view input, Handler& handler) {
+    ParseBuffer(input, handler);
+}
+
+void Parse(std::istream& input, Handler& handler) {
+    Parse(std::string_view(ReadAll(input)), handler);
+}
+
+void ParseFile(const std::string& path, Handler& handler) {
+    WithFileContents(path, [&handler](std::string_view contents) {
+        Parse(contents, handler);
+    });
+}
+
+std::vector<std::string_view> SplitArray(std::string_view text) {
+    std::vector<std::string_view> items;
+    SplitContainer(text, '[', ']', [&items](std::string_view item) {
+        items.push_back(item);
+    });
+    return items;
+}
+
+std::vector<std::pair<std::string_view, std::string_view>> SplitDict(std::string_view text) {
+    std::vector<std::pair<std::string_view, std::string_view>> items;
+    SplitContainer(text, '{', '}', [&items](std::string_view item) {
+        if (item.empty() || item.front() != '"') {
+            throw ParsingError("Dict key expected"s);
         }
+        size_t key_end = 1;
+        while (key_end < item.size() && item[key_end] != '"') {
+            key_end += (item[key_end] == '\\') ? 2 : 1;
+        }
+        if (key_end >= item.size()) {
+            throw ParsingError("String parsing error"s);
+        }
+        const std::string_view value = TrimSpaces(item.substr(key_end + 1));
+        if (value.empty() || value.front() != ':') {
+            throw ParsingError("Dict key must be followed by ':'"s);
+        }
+        items.emplace_back(item.substr(1, key_end - 1), TrimSpaces(value.substr(1)));
+    });
+    return items;
+}
+
+void LazyDict::Add(std::string key, std::string_view text) {
+    const auto it = std::find_if(items_.begin(), items_.end(), [&key](const auto& item) {
+        return item.first == key;
+    });
+    if (it != items_.end()) {
+        it->second = Value{std::string(text), std::nullopt};
+        return;
     }
-    out.put('"');
+    items_.emplace_back(std::move(key), Value{std::string(text), std::nullopt});
 }
 
-template <>
-void PrintValue<std::string>(const std::string& value, const PrintContext& ctx) {
-    PrintString(value, ctx.out);
+const Node* LazyDict::Find(std::string_view key) const {
+    const Value* value = FindValue(key);
+    if (!value) {
+        return nullptr;
+    }
+    if (!value->node) {
+        TreeBuilder builder;
+        ParseBuffer(value->text, builder);
+        value->node = builder.Extract();
+    }
+    return &*value->node;
 }
 
-template <>
-void PrintValue<std::nullptr_t>(const std::nullptr_t&, const PrintContext& ctx) {
-    ctx.out << "null"sv;
+bool LazyDict::IsParsed(std::string_view key) const {
+    const Value* value = FindValue(key);
+    return value && value->node.has_value();
 }
 
-// В специализации шаблона PrintValue для типа bool параметр value передаётся
-// по константной ссылке, как и в основном шаблоне.
-// В качестве альтернативы можно использовать перегрузку:
-// void PrintValue(bool value, const PrintContext& ctx);
-template <>
-void PrintValue<bool>(const bool& value, const PrintContext& ctx) {
-    ctx.out << (value ? "true"sv : "false"sv);
+const LazyDict::Value* LazyDict::FindValue(std::string_view key) const {
+    const auto it = std::find_if(items_.begin(), items_.end(), [key](const auto& item) {
+        return item.first == key;
+    });
+    return it == items_.end() ? nullptr : &it->second;
 }
 
-template <>
-void PrintValue<Array>(const Array& nodes, const PrintContext& ctx) {
-    std::ostream& out = ctx.out;
-    out << "[\n"sv;
-    bool first = true;
-    auto inner_ctx = ctx.Indented();
-    for (const Node& node : nodes) {
-        if (first) {
-            first = false;
-        } else {
-            out << ",\n"sv;
-        }
-        inner_ctx.PrintIndent();
-        PrintNode(node, inner_ctx);
+ViewDict::const_iterator ViewDict::find(std::string_view key) const {
+    const auto it = std::lower_bound(begin(), end(), key, [](const value_type& item, std::string_view key) {
+        return item.first < key;
+    });
+    return (it != end() && it->first == key) ? it : end();
+}
+
+Dict::Dict(std::initializer_list<value_type> items) {
+    for (const value_type& item : items) {
+        emplace(item.first, item.second);
     }
-    out.put('\n');
-    ctx.PrintIndent();
-    out.put(']');
 }
 
-template <>
-void PrintValue<Dict>(const Dict& nodes, const PrintContext& ctx) {
-    std::ostream& out = ctx.out;
-    out << "{\n"sv;
-    bool first = true;
-    auto inner_ctx = ctx.Indented();
-    for (const auto& [key, node] : nodes) {
-        if (first) {
-            first = false;
-        } else {
-            out << ",\n"sv;
-        }
-        inner_ctx.PrintIndent();
-        PrintString(key, ctx.out);
-        out << ": "sv;
-        PrintNode(node, inner_ctx);
+size_t ViewDict::count(std::string_view key) const {
+    return find(key) == end() ? 0 : 1;
+}
+
+const ViewNode& ViewDict::at(std::string_view key) const {
+    const auto it = find(key);
+    if (it == end()) {
+        throw std::out_of_range("No key '"s + std::string(key) + "' in dict"s);
     }
-    out.put('\n');
-    ctx.PrintIndent();
-    out.put('}');
+    return it->second;
 }
 
-void PrintNode(const Node& node, const PrintContext& ctx) {
-    std::visit(
-        [&ctx](const auto& value) {
-            PrintValue(value, ctx);
-        },
-        node.GetValue());
+ViewDocument::ViewDocument(std::shared_ptr<const void> storage, std::string_view input)
+    : storage_(std::move(storage))
+    // узлов в дереве обычно меньше, чем байт во входе, поэтому первый блок арены - четверть его размера
+    , arena_(std::make_unique<std::pmr::monotonic_buffer_resource>(std::max<size_t>(input.size() / 4, 1024))) {
+    ViewTreeBuilder builder(input, *arena_);
+    ParseBuffer(input, builder);
+    root_ = builder.Extract();
 }
 
-}  // namespace
+ViewDocument LoadView(std::string input) {
+    // строка переносится в кучу, чтобы представления не зависели от перемещений документа
+    auto buffer = std::make_shared<const std::string>(std::move(input));
+    const std::string_view contents = *buffer;
+    return ViewDocument(std::move(buffer), contents);
+}
 
-Document Load(std::istream& input) {
-    return Document{LoadNode(input)};
+ViewDocument LoadView(std::shared_ptr<const void> storage, std::string_view input) {
+    return ViewDocument(std::move(storage), input);
+}
+
+ViewDocument LoadView(std::istream& input) {
+    return LoadView(ReadAll(input));
+}
+
+ViewDocument LoadViewFile(const std::string& path) {
+    FileContents file = ReadFileContents(path);
+    const std::string_view contents = file.contents;
+    return ViewDocument(std::move(file.storage), contents);
 }
 
-void Print(const Document& doc, std::ostream& output) {
-    PrintNode(doc.GetRoot(), PrintContext{output});
+Node ToNode(const ViewNode& node) {
+    if (node.IsArray()) {
+        Array array;
+        array.reserve(node.AsArray().size());
+        for (const ViewNode& item : node.AsArray()) {
+            array.push_back(ToNode(item));
+        }
+        return Node(std::move(array));
+    }
+    if (node.IsDict()) {
+        // ключи представления уже упорядочены, поэтому добавляются в конец словаря
+        Dict dict;
+        dict.reserve(node.AsDict().size());
+        for (const auto& [key, value] : node.AsDict()) {
+            dict.emplace(std::string(key), ToNode(value));
+        }
+        return Node(std::move(dict));
+    }
+    if (node.IsString()) {
+        return Node(std::string(node.AsString()));
+    }
+    if (node.IsInt()) {
+        return Node(node.AsInt());
+    }
+    if (node.IsPureDouble()) {
+        return Node(node.AsDouble());
+    }
+    if (node.IsBool()) {
+        return Node(node.AsBool());
+    }
+    return Node(nullptr);
 }
 
 }  // namespace json
\ No newline at end of file
@@ -1,17 +1,97 @@
 #pragma once
 
+#include <algorithm>
+#include <initializer_list>
 #include <iostream>
-#include <map>
+#include <memory>
+#include <memory_resource>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
 namespace json {
 
 class Node;
-using Dict = std::map<std::string, Node>;
 using Array = std::vector<Node>;
 
+/*
+Словарь JSON: пары ключ-значение в одном векторе, упорядоченные по ключу (порядок обхода - как у std::map).
+В словарях документов справочника от 3 до 10 ключей, и такой словарь занимает один блок памяти
+вместо узла на каждый ключ. В небольших словарях ключ ищется перебором, в остальных - двоичным поиском.
+Вставка сдвигает пары после нового ключа, поэтому словарь рассчитан на небольшое число ключей
+*/
+class Dict {
+public:
+    using key_type = std::string;
+    using mapped_type = Node;
+    using value_type = std::pair<std::string, Node>;
+    using iterator = std::vector<value_type>::iterator;
+    using const_iterator = std::vector<value_type>::const_iterator;
+
+    Dict() = default;
+
+    // Повторяющиеся ключи пропускаются, как в std::map
+    Dict(std::initializer_list<value_type> items);
+
+    iterator begin() {
+        return items_.begin();
+    }
+    iterator end() {
+        return items_.end();
+    }
+    const_iterator begin() const {
+        return items_.begin();
+    }
+    const_iterator end() const {
+        return items_.end();
+    }
+    size_t size() const {
+        return items_.size();
+    }
+    bool empty() const {
+        return items_.empty();
+    }
+    void reserve(size_t capacity) {
+        items_.reserve(capacity);
+    }
+
+    iterator find(std::string_view key);
+    const_iterator find(std::string_view key) const;
+
+    size_t count(std::string_view key) const;
+
+    // Если ключа нет, выбрасывает исключение out_of_range
+    Node& at(std::string_view key);
+    const Node& at(std::string_view key) const;
+
+    // Возвращает значение по ключу, добавляя пустое значение, если ключа нет
+    Node& operator[](std::string_view key);
+
+    // Добавляет пару, если ключа еще нет. Возвращает пару с ключом и признак добавления
+    template <typename Value>
+    std::pair<iterator, bool> emplace(std::string key, Value&& value);
+
+    // Добавляет пару или заменяет значение существующего ключа
+    template <typename Value>
+    std::pair<iterator, bool> insert_or_assign(std::string key, Value&& value);
+
+    bool operator==(const Dict& other) const;
+    bool operator!=(const Dict& other) const {
+        return !(*this == other);
+    }
+
+private:
+    // До скольких ключей поиск идет перебором
+    static constexpr size_t LINEAR_SEARCH_MAX_SIZE = 8;
+
+    std::vector<value_type> items_;
+
+    // Первая пара с ключом не меньше key
+    iterator LowerBound(std::string_view key);
+};
+
 class ParsingError : public std::runtime_error {
 public:
     using runtime_error::runtime_error;
@@ -85,7 +165,7 @@ public:
     bool IsArray() const {
         return std::holds_alternative<Array>(*this);
     }
-    const Array& AsArray() const {
+    const Array& AsArray() const& {
         using namespace std::literals;
         if (!IsArray()) {
             throw std::logic_error("Not an array"s);
@@ -93,11 +173,20 @@ public:
 
         return std::get<Array>(*this);
     }
+    // У временного узла значение забирается перемещением, без копирования
+    Array AsArray() && {
+        using namespace std::literals;
+        if (!IsArray()) {
+            throw std::logic_error("Not an array"s);
+        }
+
+        return std::move(std::get<Array>(*this));
+    }
 
     bool IsString() const {
         return std::holds_alternative<std::string>(*this);
     }
-    const std::string& AsString() const {
+    const std::string& AsString() const& {
         using namespace std::literals;
         if (!IsString()) {
             throw std::logic_error("Not a string"s);
@@ -105,11 +194,20 @@ public:
 
         return std::get<std::string>(*this);
     }
+    // У временного узла значение забирается перемещением, без копирования
+    std::string AsString() && {
+        using namespace std::literals;
+        if (!IsString()) {
+            throw std::logic_error("Not a string"s);
+        }
+
+        return std::move(std::get<std::string>(*this));
+    }
 
     bool IsDict() const {
         return std::holds_alternative<Dict>(*this);
     }
-    const Dict& AsDict() const {
+    const Dict& AsDict() const& {
         using namespace std::literals;
         if (!IsDict()) {
             throw std::logic_error("Not a dict"s);
@@ -117,6 +215,15 @@ public:
 
         return std::get<Dict>(*this);
     }
+    // У временного узла значение забирается перемещением, без копирования
+    Dict AsDict() && {
+        using namespace std::literals;
+        if (!IsDict()) {
+            throw std::logic_error("Not a dict"s);
+        }
+
+        return std::move(std::get<Dict>(*this));
+    }
 
     bool operator==(const Node& rhs) const {
         return GetValue() == rhs.GetValue();
@@ -136,6 +243,74 @@ inline bool operator!=(const Node& lhs, const Node& rhs) {
     return !(lhs == rhs);
 }
 
+inline Dict::iterator Dict::LowerBound(std::string_view key) {
+    return std::lower_bound(items_.begin(), items_.end(), key, [](const value_type& item, std::string_view key) {
+        return std::string_view(item.first) < key;
+    });
+}
+
+inline Dict::iterator Dict::find(std::string_view key) {
+    if (items_.size() <= LINEAR_SEARCH_MAX_SIZE) {
+        return std::find_if(items_.begin(), items_.end(), [key](const value_type& item) {
+            return item.first == key;
+        });
+    }
+    const iterator it = LowerBound(key);
+    return (it != items_.end() && it->first == key) ? it : items_.end();
+}
+
+inline Dict::const_iterator Dict::find(std::string_view key) const {
+    return const_cast<Dict&>(*this).find(key);
+}
+
+inline size_t Dict::count(std::string_view key) const {
+    return find(key) == end() ? 0 : 1;
+}
+
+inline Node& Dict::at(std::string_view key) {
+    using namespace std::literals;
+    const iterator it = find(key);
+    if (it == items_.end()) {
+        throw std::out_of_range("No key '"s + std::string(key) + "' in dict"s);
+    }
+    return it->second;
+}
+
+inline const Node& Dict::at(std::string_view key) const {
+    return const_cast<Dict&>(*this).at(key);
+}
+
+inline Node& Dict::operator[](std::string_view key) {
+    iterator it = LowerBound(key);
+    if (it == items_.end() || it->first != key) {
+        it = items_.emplace(it, std::string(key), Node());
+    }
+    return it->second;
+}
+
+template <typename Value>
+std::pair<Dict::iterator, bool> Dict::emplace(std::string key, Value&& value) {
+    const iterator it = LowerBound(key);
+    if (it != items_.end() && it->first == key) {
+        return {it, false};
+    }
+    return {items_.emplace(it, std::move(key), Node(std::forward<Value>(value))), true};
+}
+
+template <typename Value>
+std::pair<Dict::iterator, bool> Dict::insert_or_assign(std::string key, Value&& value) {
+    const iterator it = LowerBound(key);
+    if (it != items_.end() && it->first == key) {
+        it->second = Node(std::forward<Value>(value));
+        return {it, false};
+    }
+    return {items_.emplace(it, std::move(key), Node(std::forward<Value>(value))), true};
+}
+
+inline bool Dict::operator==(const Dict& other) const {
+    return items_ == other.items_;
+}
+
 class Document {
 public:
     explicit Document(Node root)
@@ -158,8 +333,387 @@ inline bool operator!=(const Document& lhs, const Document& rhs) {
     return !(lhs == rhs);
 }
 
+/*
+Словарь, значения которого хранятся записями JSON и разбираются при первом обращении: так разделы
+документа, которые могут не понадобиться, не разбираются заранее (записи можно получить через SplitDict).
+Записи копируются, поэтому словарь не зависит от буфера, из которого они взяты. Ошибка в записи значения
+обнаруживается только при обращении к нему. Обращение может разобрать значение, поэтому обращаться
+к словарю из нескольких потоков одновременно нельзя
+*/
+class LazyDict {
+public:
+    // Добавляет запись значения по ключу, повторный ключ заменяет прежнее значение
+    void Add(std::string key, std::string_view text);
+
+    // Значение по ключу или nullptr, если ключа нет. При ошибке в записи значения
+    // выбрасывает исключение ParsingError (и при следующих обращениях тоже)
+    const Node* Find(std::string_view key) const;
+
+    // Разобрано ли уже значение по ключу
+    bool IsParsed(std::string_view key) const;
+
+    size_t size() const {
+        return items_.size();
+    }
+    bool empty() const {
+        return items_.empty();
+    }
+
+private:
+    struct Value {
+        std::string text;
+        mutable std::optional<Node> node;
+    };
+
+    // разделов в документе немного, поэтому ключ ищется перебором
+    std::vector<std::pair<std::string, Value>> items_;
+
+    const Value* FindValue(std::string_view key) const;
+};
+
+/*
+Обработчик событий потокового разбора (SAX): Parse сообщает ему о содержимом документа
+по порядку, не строя дерево. Строки и ключи передаются как string_view, действительные
+только до возврата из метода
+*/
+class Handler {
+public:
+    virtual ~Handler() = default;
+
+    virtual void StartArray() = 0;
+    virtual void EndArray() = 0;
+    virtual void StartDict() = 0;
+    virtual void EndDict() = 0;
+    // Ключ словаря, следующее событие - начало его значения
+    virtual void Key(std::string_view key) = 0;
+    virtual void String(std::string_view value) = 0;
+    virtual void Int(int value) = 0;
+    virtual void Double(double value) = 0;
+    virtual void Bool(bool value) = 0;
+    virtual void Null() = 0;
+};
+
+/*
+Строит дерево по событиям разбора: так работает Load, а обработчики событий могут
+с его помощью собирать отдельные части документа. Повторяющийся ключ словаря - ошибка ParsingError
+*/
+class TreeBuilder final : public Handler {
+public:
+    void StartArray() override;
+    void EndArray() override;
+    void StartDict() override;
+    void EndDict() override;
+    void Key(std::string_view key) override;
+    void String(std::string_view value) override;
+    void Int(int value) override;
+    void Double(double value) override;
+    void Bool(bool value) override;
+    void Null() override;
+
+    // Получено ли одно значение целиком
+    bool IsComplete() const {
+        return has_root_ && frames_.empty();
+    }
+
+    // Забирает построенное значение, после чего можно строить следующее
+    Node Extract() {
+        has_root_ = false;
+        return std::move(root_);
+    }
+
+private:
+    // Открытый массив или словарь и ключ, значение которого сейчас читается
+    struct Frame {
+        Node container;
+        std::string key;
+    };
+
+    std::vector<Frame> frames_;
+    Node root_;
+    bool has_root_ = false;
+
+    void AddValue(Node value);
+};
+
+// Читает поток до конца и разбирает JSON-документ
 Document Load(std::istream& input);
 
+// Разбирает JSON-документ из непрерывного буфера
+Document Load(std::string_view input);
+
+// Разбирает JSON-документ из файла, отображенного в память.
+// Если файл не удалось открыть, выбрасывает исключение runtime_error
+Document LoadFile(const std::string& path);
+
+// Читает поток до конца в одну строку
+std::string ReadAll(std::istream& input);
+
+/*
+Читает из потока запись одного значения JSON: от первого непробельного символа до скобки, закрывающей
+корневой массив или словарь (скобки внутри строк, в том числе экранированные, не учитываются), а для
+простого значения - до пробельного символа. Остаток потока не читается, поэтому после значения в нем
+могут идти другие данные. Корректность записи не проверяется - ошибки в ней найдет разбор значения.
+Если поток закончился раньше, чем значение, выбрасывает исключение ParsingError
+*/
+std::string ReadValue(std::istream& input);
+
+// Содержимое файла: отображение в память или, если отобразить не удалось, прочитанная строка.
+// Содержимое действительно, пока жив storage
+struct FileContents {
+    std::shared_ptr<const void> storage;
+    std::string_view contents;
+};
+
+// Открывает файл и отображает его в память. Если файл не удалось открыть, выбрасывает исключение runtime_error
+FileContents ReadFileContents(const std::string& path);
+
+/*
+Разбивает запись массива (от '[' до ']', пробелы вокруг допускаются) на записи его элементов
+без пробелов вокруг, не разбирая сами элементы: по структурным позициям (json_scanner.h) отслеживаются
+только скобки и строки. Так элементы большого массива можно разобрать по отдельности, в том числе
+в разных потоках. Корректность элементов не проверяется - ошибки в них найдет разбор самих элементов.
+Если запись не массив или скобки в ней не сбалансированы, выбрасывает исключение ParsingError
+*/
+std::vector<std::string_view> SplitArray(std::string_view text);
+
+// То же для словаря: пары из ключа в том виде, как он записан (без кавычек, экранирование
+// не раскрывается), и записи значения
+std::vector<std::pair<std::string_view, std::string_view>> SplitDict(std::string_view text);
+
+// Разбирает JSON из буфера, сообщая о его содержимом обработчику. Дерево не строится,
+// повторяющиеся ключи словаря не проверяются. При ошибке выбрасывает исключение ParsingError
+void Parse(std::string_view input, Handler& handler);
+
+// То же для потока, прочитанного до конца
+void Parse(std::istream& input, Handler& handler);
+
+// То же для файла, отображенного в память. Если файл не удалось открыть, выбрасывает исключение runtime_error
+void ParseFile(const std::string& path, Handler& handler);
+
+// Выводит документ с отступами. Вывод идет через буферизованный Writer (json_writer.h)
 void Print(const Document& doc, std::ostream& output);
 
-}  // namespace json
\ No newline at end of file
+// Выводит документ в одну строку без пробелов и отступов (например, для построчного обмена NDJSON)
+void PrintCompact(const Document& doc, std::ostream& output);
+
+/*
+ * Документ-представление: строки и ключи в нем - string_view во входной буфер, который документ
+ * хранит у себя. Копируются (с заменой escape-последовательностей) только строки с экранированием.
+ * Узлы, массивы, словари и скопированные строки размещаются в арене документа (монотонный
+ * распределитель): на разбор приходится несколько крупных выделений памяти, а узлы не владеют
+ * памятью и не имеют деструкторов, так что документ освобождается целиком за O(1).
+ * Документ только для чтения.
+ */
+
+class ViewNode;
+
+// Массив документа-представления: непрерывный участок арены документа
+class ViewArray {
+public:
+    using value_type = ViewNode;
+    using const_iterator = const ViewNode*;
+
+    ViewArray() = default;
+
+    ViewArray(const ViewNode* data, size_t size)
+        : data_(data)
+        , size_(size) {
+    }
+
+    const_iterator begin() const {
+        return data_;
+    }
+    const_iterator end() const;
+    size_t size() const {
+        return size_;
+    }
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    const ViewNode& operator[](size_t index) const;
+
+private:
+    const ViewNode* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Словарь документа-представления: пары в участке арены, упорядоченные по ключу (поиск - двоичный)
+class ViewDict {
+public:
+    using value_type = std::pair<std::string_view, ViewNode>;
+    using const_iterator = const value_type*;
+
+    ViewDict() = default;
+
+    // Пары должны быть упорядочены по ключу и не должны повторять ключи
+    ViewDict(const value_type* items, size_t size)
+        : items_(items)
+        , size_(size) {
+    }
+
+    const_iterator begin() const {
+        return items_;
+    }
+    const_iterator end() const;
+    size_t size() const {
+        return size_;
+    }
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    const_iterator find(std::string_view key) const;
+
+    size_t count(std::string_view key) const;
+
+    // Если ключа нет, выбрасывает исключение out_of_range
+    const ViewNode& at(std::string_view key) const;
+
+private:
+    const value_type* items_ = nullptr;
+    size_t size_ = 0;
+};
+
+class ViewNode final
+    : private std::variant<std::nullptr_t, ViewArray, ViewDict, bool, int, double, std::string_view> {
+public:
+    using variant::variant;
+    using Value = variant;
+
+    bool IsInt() const {
+        return std::holds_alternative<int>(*this);
+    }
+    int AsInt() const {
+        using namespace std::literals;
+        if (!IsInt()) {
+            throw std::logic_error("Not an int"s);
+        }
+        return std::get<int>(*this);
+    }
+
+    bool IsPureDouble() const {
+        return std::holds_alternative<double>(*this);
+    }
+    bool IsDouble() const {
+        return IsInt() || IsPureDouble();
+    }
+    double AsDouble() const {
+        using namespace std::literals;
+        if (!IsDouble()) {
+            throw std::logic_error("Not a double"s);
+        }
+        return IsPureDouble() ? std::get<double>(*this) : AsInt();
+    }
+
+    bool IsBool() const {
+        return std::holds_alternative<bool>(*this);
+    }
+    bool AsBool() const {
+        using namespace std::literals;
+        if (!IsBool()) {
+            throw std::logic_error("Not a bool"s);
+        }
+        return std::get<bool>(*this);
+    }
+
+    bool IsNull() const {
+        return std::holds_alternative<std::nullptr_t>(*this);
+    }
+
+    bool IsArray() const {
+        return std::holds_alternative<ViewArray>(*this);
+    }
+    const ViewArray& AsArray() const {
+        using namespace std::literals;
+        if (!IsArray()) {
+            throw std::logic_error("Not an array"s);
+        }
+        return std::get<ViewArray>(*this);
+    }
+
+    bool IsString() const {
+        return std::holds_alternative<std::string_view>(*this);
+    }
+    // Строка действительна, пока жив документ
+    std::string_view AsString() const {
+        using namespace std::literals;
+        if (!IsString()) {
+            throw std::logic_error("Not a string"s);
+        }
+        return std::get<std::string_view>(*this);
+    }
+
+    bool IsDict() const {
+        return std::holds_alternative<ViewDict>(*this);
+    }
+    const ViewDict& AsDict() const {
+        using namespace std::literals;
+        if (!IsDict()) {
+            throw std::logic_error("Not a dict"s);
+        }
+        return std::get<ViewDict>(*this);
+    }
+
+    const Value& GetValue() const {
+        return *this;
+    }
+};
+
+inline ViewArray::const_iterator ViewArray::end() const {
+    return data_ + size_;
+}
+
+inline const ViewNode& ViewArray::operator[](size_t index) const {
+    return data_[index];
+}
+
+inline ViewDict::const_iterator ViewDict::end() const {
+    return items_ + size_;
+}
+
+class ViewDocument;
+
+// Разбирает JSON-документ, забирая буфер себе
+ViewDocument LoadView(std::string input);
+
+// Читает поток до конца и разбирает JSON-документ
+ViewDocument LoadView(std::istream& input);
+
+// Разбирает JSON-документ из участка буфера, который хранит storage (строки документа ссылаются на буфер).
+// Если storage пуст, буфер должен жить дольше документа
+ViewDocument LoadView(std::shared_ptr<const void> storage, std::string_view input);
+
+// Разбирает JSON-документ из файла, отображенного в память (отображение хранится в документе).
+// Если файл не удалось открыть, выбрасывает исключение runtime_error
+ViewDocument LoadViewFile(const std::string& path);
+
+// Документ можно перемещать, но не копировать: узлы ссылаются на его буферы
+class ViewDocument {
+public:
+    ViewDocument(ViewDocument&&) = default;
+    ViewDocument& operator=(ViewDocument&&) = default;
+
+    const ViewNode& GetRoot() const {
+        return root_;
+    }
+
+private:
+    // входной буфер: строка или отображение файла
+    std::shared_ptr<const void> storage_;
+    // узлы и строки с экранированием после замены escape-последовательностей
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena_;
+    ViewNode root_;
+
+    // Разбирает input, который хранится в storage. При ошибке выбрасывает исключение ParsingError
+    ViewDocument(std::shared_ptr<const void> storage, std::string_view input);
+
+    friend ViewDocument LoadView(std::string input);
+    friend ViewDocument LoadView(std::shared_ptr<const void> storage, std::string_view input);
+    friend ViewDocument LoadViewFile(const std::string& path);
+};
+
+// Копирует узел документа-представления со всеми вложенными узлами в дерево (строки копируются)
+Node ToNode(const ViewNode& node);
+
+}  // namespace json
@@ -43,8 +43,8 @@ void Builder::AddNewNodeValueToStack(Node::Value value, bool open_new_node) {
 
 Builder& Builder::Value(Node::Value value) {
     ThrowOnEmptyNodeStack();
-    // Добавляем элемент
-    AddNewNodeValueToStack(value, /*open_new*/ false);
+    // Добавляем элемент: значение уже скопировано или перемещено в параметр, дальше только перемещается
+    AddNewNodeValueToStack(std::move(value), /*open_new*/ false);
     
     return *this;
 }
@@ -53,7 +53,10 @@ Builder& Builder::Value(Node::Value value) {
 Builder::DictItemContext Builder::StartDict() {
     // проверяем, что есть куда записывать
     ThrowOnEmptyNodeStack();
-    AddNewNodeValueToStack(json::Dict{}, /*open new*/ true);
+    // место под ключи ответа выделяется сразу, чтобы словарь не перевыделялся при добавлении ключей
+    json::Dict dict;
+    dict.reserve(DICT_INITIAL_CAPACITY);
+    AddNewNodeValueToStack(std::move(dict), /*open new*/ true);
 
     return DictItemContext(*this);
 }
@@ -72,7 +75,8 @@ Builder::DictValueContext Builder::Key(std::string key) {
     
     // "открываем" новые пустой узел = элемент словаря
     json::Dict& cur_dict = std::get<json::Dict>(cur_node_value);
-    nodes_stack_.push_back(&cur_dict[key]);
+    // ключ перемещается в словарь; для повторного ключа открывается уже имеющееся значение
+    nodes_stack_.push_back(&cur_dict.emplace(std::move(key), nullptr).first->second);
 
     return DictValueContext(*this);
 }
@@ -130,7 +134,10 @@ Node Builder::Build() {
         throw std::logic_error("Build failed: There is some unfinished nodes in stack"s);
     } 
     
-    return root_;
+    // построенный объект отдается перемещением, строитель после этого пуст
+    Node result = std::move(root_);
+    root_ = Node();
+    return result;
 }
 
 
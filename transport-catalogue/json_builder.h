@@ -20,19 +20,29 @@ private:
 public:
 
     Builder () {
+        nodes_stack_.reserve(STACK_INITIAL_CAPACITY);
         nodes_stack_.emplace_back(&root_);
     };
 
+    // Значение принимается по значению: временные объекты (в том числе массивы и словари,
+    // переданные через std::move) перемещаются в строящийся узел без копирования
     Builder& Value(Node::Value value);  // было Builder&
     DictItemContext StartDict();
     DictValueContext Key(std::string key);
     ArrayItemContext StartArray();
     BaseContext EndDict();
     BaseContext EndArray();
+    // Отдает построенный объект перемещением, повторный вызов вернет пустой узел
     Node Build();
 
 
 private:
+    // Сколько ключей помещается в словарь, открытый StartDict, без перевыделения памяти
+    // (в ответах на запросы не больше пяти ключей)
+    static constexpr size_t DICT_INITIAL_CAPACITY = 6;
+    // Глубина вложенности, до которой стек открытых узлов не перевыделяется
+    static constexpr size_t STACK_INITIAL_CAPACITY = 8;
+
     // конструируемый объект
     Node root_;
 
@@ -2,6 +2,11 @@
 
 #include <iostream>
 #include <algorithm>
+#include <charconv>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <variant>
 
 /*
  * Здесь размещен код наполнения транспортного справочника данными из JSON,
@@ -19,18 +24,13 @@ json::Document JsonReader::ReadJson(std::istream& input) const {
 // Загружает Json в данный класс
 void JsonReader::LoadJson(std::istream& input) {
     document_with_requests_ = std::move(ReadJson(input));
+    lazy_sections_ = json::LazyDict{};
 }
 
-
-/**
- * Удаляет пробелы в начале и конце строки
- */
-static std::string_view Trim(std::string_view string) {
-    const auto start = string.find_first_not_of(' ');
-    if (start == string.npos) {
-        return {};
-    }
-    return string.substr(start, string.find_last_not_of(' ') + 1 - start);
+// Загружает Json из файла
+void JsonReader::LoadJsonFile(const std::string& path) {
+    document_with_requests_ = json::LoadFile(path);
+    lazy_sections_ = json::LazyDict{};
 }
 
 
@@ -69,7 +69,7 @@ static svg::Color GetColorFromJsonNode(const json::Node& color_node) {
 
 
 // Вспомогательная функция для обнаружения параметров в settings map json и записи их в структуру, 
-// Предназначена для сокращения функции GetRenderSettingsFromDocument
+// Предназначена для сокращения функции GetRenderSettingsFromSection
 static renderer::RenderingFormatOptions ParseRenderingParameters(const json::Dict& settings_map) {
     renderer::RenderingFormatOptions render_options;
     if (settings_map.count("width")) {
@@ -131,256 +131,654 @@ static renderer::RenderingFormatOptions ParseRenderingParameters(const json::Dic
 }
 
 
-// Общая функция для формирования структуры настроек отрисовки
-static renderer::RenderingFormatOptions GetRenderSettingsFromDocument(const json::Document& document) {
+// Общая функция для формирования структуры настроек отрисовки из раздела render_settings
+// (settings_node == nullptr, если раздела в документе нет)
+static renderer::RenderingFormatOptions GetRenderSettingsFromSection(const json::Node* settings_node) {
     // Создаем структуру, которую будем заполнять значениями из документа
     // По умолчанию она заполнена некоторыми адекватными значениями
     renderer::RenderingFormatOptions render_options;
+    if (!settings_node) {
+        std::cerr << "There is no render_settings. Default render options will be used!"sv << std::endl;
+        return render_options;
+    }
     try {
-        // 0. Получаем map запросов
-        if (!document.GetRoot().IsDict()) {
-            std::cerr << "LOG err: in GetRenderSettingsFromDocument document.GetRoot() is not a map! \n Default render options is be used!"sv << std::endl;
-            return render_options;
-        }
-        const json::Dict& main_node = document.GetRoot().AsDict();
-        
-        // 1. Парсим запросы "render_settings"
-        const json::Node& settings_node = main_node.at("render_settings");
-        
         // Проверяем, что render_settings правильно считалась как map
-        if (!settings_node.IsDict()) {
+        if (!settings_node->IsDict()) {
             std::cerr << "There is no render_settings" << std::endl;
         }
-        // 2. Получаем словарь параметров
-        const json::Dict& settings_map = settings_node.AsDict(); 
+        // Получаем словарь параметров
+        const json::Dict& settings_map = settings_node->AsDict(); 
 
-        // 3. Поэлементно добавляем в структуру параметров параметры из json-документа
+        // Поэлементно добавляем в структуру параметров параметры из json-документа
         render_options = ParseRenderingParameters(settings_map); 
 
     }
-    catch (std::logic_error& e) {
-        std::cerr << "LOG err: from json_reader GetRenderSettingsFromDocument: main_node is not a map => "s << e.what() << std::endl;
-    }
     catch (std::exception& e) {
-        std::cerr << "LOG err: from json_reader GetRenderSettingsFromDocument: "s << e.what() << std::endl;
+        std::cerr << "LOG err: from json_reader GetRenderSettingsFromSection: "s << e.what() << std::endl;
     }
 
     return render_options;
 }
 
 
-// Обработка запросов на добавление остановок
-// Идем по списку команд и обрабатывааем только запросы на добавление остановок
-void JsonReader::AddStopsToCatalogue(transport::TransportCatalogue& catalogue) const {
-    for(const auto& command_cur : stop_commands_) {
-        // если запрос не про остановку, то переходим к следующему запросу
-        if (Trim(command_cur.GetCommandType()) != "Stop"s) {
-            continue;
-        }
-        
-        // формируем остановку
-        domain::Stop stop_cur;
-        stop_cur.name = command_cur.GetName();
-        stop_cur.coordinates = command_cur.GetCoordinates(); 
-        // добавляем в каталог
-        catalogue.AddStop(stop_cur, command_cur.GetDistances());  
-    }
-    return;
+void JsonReader::SetThreadsCount(size_t threads_count) {
+    threads_count_ = std::max<size_t>(1, threads_count);
+    thread_pool_.reset();
 }
 
-// Обработка запросов на добавление маршрутов автобусов
-// идем по списку команд и обрабатываем только добавление автобусов
-void JsonReader::AddBusesToCatalogue(transport::TransportCatalogue& catalogue) const {
-        // 1. Обработка запросов на добавление маршрутов автобусов
-    for(const BusCommand& command_cur : bus_commands_) {
-        // если запрос не про остановку, то переходим к следующему запросу
-        if (Trim(command_cur.GetCommandType()) != "Bus"s) {
-            continue;
-        }
-        // Формируем вектор остановок с учетом типа маршрута
-        // немного криво, потому что надо преобразовать тип элементов массива из string в string_view  
-        std::vector<std::string_view> stops_names_on_route;
-        for (const auto& stop_name : command_cur.GetStops()) {
-            stops_names_on_route.emplace_back(stop_name);
-        }
-
-        // std::vector<std::string> stops_names_on_route = command_cur.GetStops();
-        if (!command_cur.IsRoundTrip()) {
-            stops_names_on_route.insert(stops_names_on_route.end(), std::next(stops_names_on_route.rbegin()), stops_names_on_route.rend());
-        }
-        // добавляем в каталог 
-        catalogue.AddBus(command_cur.GetName(), stops_names_on_route, command_cur.IsRoundTrip());
-    }
-    return;
+void JsonReader::SetResponseCacheEnabled(bool enabled) {
+    response_cache_enabled_ = enabled;
 }
 
-
-void JsonReader::ApplyCommands(transport::TransportCatalogue& catalogue) {
-    // Реализуйте метод самостоятельно
-    // Считываем команды из документа 
-    FormAllRequestsData(document_with_requests_);
-
-    // 0. Обработка запросов на добавление остановок
-    AddStopsToCatalogue(catalogue);
-
-    // 1. Обработка запросов на добавление маршрутов автобусов
-    AddBusesToCatalogue(catalogue);
-
-    return;
-
+void JsonReader::SetRouterMode(graph::RouterMode mode) {
+    router_mode_ = mode;
 }
 
 void JsonReader::ApplyRenderSettings(renderer::MapRenderer& renderer) const {
     // Формируем структуру
-    renderer::RenderingFormatOptions parameters = GetRenderSettingsFromDocument(document_with_requests_);
+    renderer::RenderingFormatOptions parameters = GetRenderSettingsFromSection(FindSection("render_settings"sv));
     // Задаем/передаем параметры отрисовщику 
     renderer.SetFormatOptions(parameters);
 
 }
 
 
-static StopCommand FormStopCommand(const json::Dict& request_map) {
-    if (request_map.at("type").AsString() != "Stop"s) {
-        throw std::logic_error("LOG err: in FormStopCommand command type is not \"Stop\" => command_type : "s + request_map.at("type").AsString() );
-    }
-    // инициируем новую команду на добавление остановки
-    StopCommand stop_command;
-    // Записываем имя
-    stop_command.SetName(request_map.at("name").AsString());
-    // Вытаскиваем и записываем координаты
-    stop_command.SetCoordinates(request_map.at("latitude").AsDouble(), request_map.at("longitude").AsDouble());
-    // Вытаскиваем и записываем расстояния
-    const json::Dict& distances_in_request = request_map.at("road_distances").AsDict();
-    for (const auto& [stop, distance] : distances_in_request) {
-        stop_command.AddDistance(stop, distance.AsInt());
+// Остановка из запроса base_requests (названия ссылаются на документ с запросом)
+struct StopRequestView {
+    std::string_view name;
+    geo::Coordinates coordinates;
+    std::vector<std::pair<std::string_view, int>> distances;
+};
+
+// Читает и проверяет запрос на добавление остановки: ошибочный запрос не должен менять каталог.
+// Словарь запроса - из документа-представления (json::ViewDict) или из дерева (json::Dict).
+// Вектор расстояний переиспользуется между запросами
+template <typename DictType>
+static void DecodeStopRequest(const DictType& request_map, StopRequestView& stop) {
+    stop.name = request_map.at("name").AsString();
+    stop.coordinates.lat = request_map.at("latitude").AsDouble();
+    stop.coordinates.lng = request_map.at("longitude").AsDouble();
+    stop.distances.clear();
+    for (const auto& [stop_name, distance] : request_map.at("road_distances").AsDict()) {
+        stop.distances.emplace_back(stop_name, distance.AsInt());
     }
-
-    return stop_command;
 }
 
+// Добавляет прочитанную остановку с расстояниями в каталог без промежуточных строк
+static void AddStopFromView(transport::TransportCatalogue& catalogue, const StopRequestView& stop) {
+    domain::Stop stop_cur;
+    stop_cur.name = stop.name;
+    stop_cur.coordinates = stop.coordinates;
+    catalogue.AddStop(std::move(stop_cur));
+    for (const auto& [stop_name, distance] : stop.distances) {
+        catalogue.SetDistanceBetweenStops(stop.name, stop_name, distance);
+    }
+}
 
-static BusCommand FormBusCommand(const json::Dict& request_map) {
-    // инициируем новую команду на добавление маршрута
-    BusCommand bus_command;
-    // Записываем имя
-    bus_command.SetName(request_map.at("name").AsString());
-    // Записываем тип маршрута
-    request_map.at("is_roundtrip").AsBool() ? bus_command.SetRoundTrip() : bus_command.SetStraightTrip();
-    // Вытаскиваем список остановок и записываем
-    const json::Array& stops_array = request_map.at("stops").AsArray();
-
-    for (const auto& stop_node : stops_array) {
-        std::string stop_name_tmp = stop_node.AsString();
-        bus_command.AddStop(stop_name_tmp);
+// Маршрут из запроса base_requests (названия ссылаются на документ с запросом)
+struct BusRequestView {
+    std::string_view name;
+    bool is_roundtrip = false;
+    std::vector<std::string_view> stops;
+};
+
+// Читает запрос на добавление маршрута. Вектор остановок переиспользуется между запросами
+template <typename DictType>
+static void DecodeBusRequest(const DictType& request_map, BusRequestView& bus) {
+    bus.name = request_map.at("name").AsString();
+    bus.is_roundtrip = request_map.at("is_roundtrip").AsBool();
+    bus.stops.clear();
+    for (const auto& stop_node : request_map.at("stops").AsArray()) {
+        bus.stops.push_back(stop_node.AsString());
     }
+}
 
-    return bus_command;
+// Тип запроса base_requests
+enum class BaseRequestKind {
+    STOP,
+    BUS,
+};
+
+// Читает запрос base_requests в stop или bus по его типу и возвращает тип.
+// Это единственный разбор запросов base_requests: им пользуются все способы загрузки базы
+template <typename DictType>
+static BaseRequestKind DecodeBaseRequest(const DictType& request_map, StopRequestView& stop, BusRequestView& bus) {
+    const std::string_view request_type = request_map.at("type").AsString();
+    if (request_type == "Stop"sv) {
+        DecodeStopRequest(request_map, stop);
+        return BaseRequestKind::STOP;
+    }
+    if (request_type == "Bus"sv) {
+        DecodeBusRequest(request_map, bus);
+        return BaseRequestKind::BUS;
+    }
+    throw std::logic_error("LOG err: in StreamingHandler -> Unknown command type"s);
 }
 
-// Добавляет запрос типа base_requests в список комманд stop_commands_ или bus_commands_
-void JsonReader::AddRequestToCommands(const json::Dict& request_map) {
-    // считываем тип запроса
-    const std::string& request_type = request_map.at("type").AsString();
-    if (request_type == "Stop"s) {
-        // инициируем новую команду на добавление остановки
-        StopCommand stop_command = FormStopCommand(request_map);
-        // Добавляем сформированную команду в перечень команд на задание остановки
-        stop_commands_.push_back(stop_command);
-        // Переходим к следующему запросу
+// Запрос base_requests, разобранный отдельно от документа: запрос или текст ошибки в нем.
+// Документ хранится вместе с запросом: строки с экранированием лежат в его буфере
+struct DecodedBaseRequest {
+    std::optional<json::ViewDocument> document;
+    bool is_valid = false;
+    BaseRequestKind kind = BaseRequestKind::STOP;
+    StopRequestView stop;
+    BusRequestView bus;
+    std::string error;
+};
+
+// Разбирает запись одного запроса base_requests. Ошибки в записи JSON (ParsingError)
+// выбрасываются, как при разборе всего документа, а ошибки в содержании запроса сохраняются.
+// Строки документа ссылаются на request_text, который должен жить дольше результата
+static DecodedBaseRequest DecodeBaseRequestText(std::string_view request_text) {
+    DecodedBaseRequest decoded;
+    decoded.document = json::LoadView(nullptr, request_text);
+    try {
+        decoded.kind = DecodeBaseRequest(decoded.document->GetRoot().AsDict(), decoded.stop, decoded.bus);
+        decoded.is_valid = true;
+    }
+    catch (const std::exception& e) {
+        decoded.error = e.what();
     }
-    else if (request_type == "Bus"s) {
-        // инициируем новую команду на добавление маршрута
-        BusCommand bus_command = FormBusCommand(request_map);
+    return decoded;
+}
 
-        // Добавляем сформированную комманду в перечень команд на задание маршрута
-        bus_commands_.push_back(bus_command);
-        // Переходим к следующему запросу
+RequestType request_detail::ParseRequestType(std::string_view type_name) {
+    if (type_name == "Stop"sv) {
+        return RequestType::STOP;
     }
-    else {
-        throw std::logic_error("LOG err: in FormAllRequestsData -> Unknown command type"s);
+    if (type_name == "Bus"sv) {
+        return RequestType::BUS;
+    }
+    if (type_name == "Map"sv) {
+        return RequestType::MAP;
+    }
+    if (type_name == "Route"sv) {
+        return RequestType::ROUTE;
+    }
+    if (type_name == "Suggest"sv) {
+        return RequestType::SUGGEST;
     }
+    return RequestType::UNKNOWN;
 }
 
-// Добавляет запрос типа stat_request в список запросов к базе данных requests_
-void JsonReader::AddRequestToRequests(const json::Dict& request_map) {
+// Формирует описание запроса типа stat_request из словаря дерева (json::Dict) или документа-представления (json::ViewDict)
+template <typename DictType>
+static RequestDescription FormRequestDescription(const DictType& request_map) {
     RequestDescription request;
     request.id = request_map.at("id").AsInt();
     if (request_map.count("name")){
         request.name = request_map.at("name").AsString();
     }
-    request.type = request_map.at("type").AsString();
+    request.type = ParseRequestType(request_map.at("type").AsString());
     // добавление инфы для запроса маршрута
-    if (request.type == "Route"s) {
+    if (request.IsRoute()) {
         request.route_from_stop = request_map.at("from").AsString();
         request.route_to_stop = request_map.at("to").AsString();
     }
-    stat_requests_.push_back(std::move(request));
+    // добавление инфы для запроса подсказок по названиям
+    if (request.IsSuggest()) {
+        request.query = request_map.at("query").AsString();
+        if (request_map.count("limit")) {
+            request.limit = static_cast<size_t>(std::max(request_map.at("limit").AsInt(), 0));
+        }
+        if (request_map.count("max_typos")) {
+            request.max_typos = static_cast<size_t>(std::max(request_map.at("max_typos").AsInt(), 0));
+        }
+    }
+    return request;
 }
 
+/*
+Находит в каталоге остановку или маршрут запроса Stop или Bus и запоминает его id в object_id.
+Для не найденных остается UNKNOWN_OBJECT_ID: ответ "not found" на них дается без обращения к каталогу
+*/
+static void ResolveRequestObject(const transport::TransportCatalogue& catalogue, RequestDescription& request) {
+    request.object_id = UNKNOWN_OBJECT_ID;
+    if (!request.name) {
+        return;
+    }
+    if (request.IsStop()) {
+        if (const domain::Stop* stop = catalogue.FindStop(*request.name)) {
+            request.object_id = stop->id;
+        }
+    }
+    else if (request.IsBus()) {
+        if (const domain::Bus* bus = catalogue.FindBus(*request.name)) {
+            request.object_id = bus->id;
+        }
+    }
+}
 
-// Формирует списки команд на заполнение базы данных и запросов к ней 
-void JsonReader::FormAllRequestsData(const json::Document& document) {
-    try {
-        // Проверяем, что запросы это map
-        if (!document.GetRoot().IsDict()) {
+
+/*
+Загрузка документа с базой. Запросы base_requests переводятся в вызовы каталога (ProcessBaseRequests):
+остановки добавляются сразу, маршруты - после всех остановок массива (они могут ссылаться на остановки,
+описанные позже). Запросы stat_requests сохраняются в список. После первого ошибочного запроса
+остальные запросы пропускаются. Как обработчик событий разбора (json::Handler) разбирает раздел
+stat_requests и раздел base_requests, заданный не массивом: запросы собираются деревом по одному
+*/
+class JsonReader::StreamingHandler final : public json::Handler {
+public:
+    StreamingHandler(JsonReader& reader, transport::TransportCatalogue& catalogue)
+        : reader_(reader)
+        , catalogue_(catalogue) {
+    }
+
+    void StartArray() override {
+        OnValue(ValueKind::ARRAY, [](json::TreeBuilder& builder) {
+            builder.StartArray();
+        });
+    }
+
+    void EndArray() override {
+        if (capturing_) {
+            Forward([](json::TreeBuilder& builder) {
+                builder.EndArray();
+            });
+        }
+        else {
+            // закончился массив запросов
+            depth_ = 1;
+        }
+    }
+
+    void StartDict() override {
+        OnValue(ValueKind::DICT, [](json::TreeBuilder& builder) {
+            builder.StartDict();
+        });
+    }
+
+    void EndDict() override {
+        if (capturing_) {
+            Forward([](json::TreeBuilder& builder) {
+                builder.EndDict();
+            });
+        }
+        else {
+            // закончился корневой словарь
+            depth_ = 0;
+        }
+    }
+
+    void Key(std::string_view key) override {
+        if (capturing_) {
+            Forward([key](json::TreeBuilder& builder) {
+                builder.Key(key);
+            });
             return;
         }
-        // 0. Получаем map запросов
-        const json::Dict& main_node = document.GetRoot().AsDict();
-        
-        // 1. Парсим запросы "base_requests"
-        const json::Node& base_requests_node = main_node.at("base_requests");
-        
-        if (base_requests_node.IsArray()) {
-            // Обрабатываем набор запросов
-            const json::Array& base_request_array = base_requests_node.AsArray();
-            for (const auto& request : base_request_array) {
-                // вытаскиваем данные текущей команды
-                const json::Dict& request_map = request.AsDict();
-                AddRequestToCommands(request_map);
+        section_key_ = key;
+        section_ = (key == "base_requests"sv) ? Section::BASE_REQUESTS
+                   : (key == "stat_requests"sv) ? Section::STAT_REQUESTS
+                   : Section::OTHER;
+    }
+
+    void String(std::string_view value) override {
+        OnValue(ValueKind::SCALAR, [value](json::TreeBuilder& builder) {
+            builder.String(value);
+        });
+    }
+
+    void Int(int value) override {
+        OnValue(ValueKind::SCALAR, [value](json::TreeBuilder& builder) {
+            builder.Int(value);
+        });
+    }
+
+    void Double(double value) override {
+        OnValue(ValueKind::SCALAR, [value](json::TreeBuilder& builder) {
+            builder.Double(value);
+        });
+    }
+
+    void Bool(bool value) override {
+        OnValue(ValueKind::SCALAR, [value](json::TreeBuilder& builder) {
+            builder.Bool(value);
+        });
+    }
+
+    void Null() override {
+        OnValue(ValueKind::SCALAR, [](json::TreeBuilder& builder) {
+            builder.Null();
+        });
+    }
+
+    /*
+    Разбирает документ по разделам корневого словаря (json::SplitDict). Разбираются только запросы,
+    а записи остальных разделов откладываются в lazy_sections_ до первого обращения. Массив base_requests
+    разбирается в документ-представление и сразу переводится в вызовы каталога, а если задано
+    несколько потоков и документ большой - делится на записи запросов (json::SplitArray), которые
+    разбираются в пуле потоков. Возвращает false, если документ нужно разобрать последовательно
+    целиком (корень не словарь или в записи документа ошибка)
+    */
+    bool ParseBySections(std::string_view input);
+
+    /*
+    Обрабатывает уже разобранный документ: документ-представление всего файла, если его не удалось
+    разобрать по разделам, или дерево из LoadJson (ApplyCommands). Корень-не словарь и разделы, кроме
+    запросов, из документа-представления копируются в дерево: документ живет только до конца разбора
+    */
+    template <typename NodeType>
+    void ProcessDocument(const NodeType& root) {
+        constexpr bool is_view = std::is_same_v<NodeType, json::ViewNode>;
+        if (!root.IsDict()) {
+            if constexpr (is_view) {
+                root_value_ = json::ToNode(root);
+            }
+            return;
+        }
+        for (const auto& [key, value] : root.AsDict()) {
+            if (key == "base_requests"sv || key == "stat_requests"sv) {
+                ProcessRequestsSection(key, value);
+            }
+            else if constexpr (is_view) {
+                sections_.insert_or_assign(std::string(key), json::ToNode(value));
             }
         }
-        else if (base_requests_node.IsDict()) {
-            // Обрабатываем один запрос
-            const json::Dict& request_map = base_requests_node.AsDict();
-            AddRequestToCommands(request_map);
+    }
+
+    // Завершает загрузку после разбора всего документа: сохраняет прочие разделы
+    void Finish() {
+        if (!root_value_) {
+            reader_.document_with_requests_ = json::Document(json::Node(std::move(sections_)));
         }
-        // to do: закомментировать следующий else
         else {
-            std::cerr << "There is no base_requests" << std::endl;
+            reader_.document_with_requests_ = json::Document(std::move(*root_value_));
         }
+    }
 
-        // 2. Парсим запросы "stat_requests"
-        const json::Node& stat_requests_node = main_node.at("stat_requests");
+private:
+    enum class ValueKind {
+        ARRAY,
+        DICT,
+        SCALAR,
+    };
+
+    enum class Section {
+        BASE_REQUESTS,
+        STAT_REQUESTS,
+        OTHER,
+    };
+
+    JsonReader& reader_;
+    transport::TransportCatalogue& catalogue_;
+
+    // уровень вложенности вне собираемых значений: 1 - в корневом словаре, 2 - в массиве запросов
+    int depth_ = 0;
+    Section section_ = Section::OTHER;
+    std::string section_key_;
+
+    // собирается ли сейчас значение деревом и на каком уровне оно начинается
+    bool capturing_ = false;
+    int capture_depth_ = 0;
+    json::TreeBuilder builder_;
+
+    // разделы документа, кроме запросов
+    json::Dict sections_;
+    // корень документа, если он не словарь
+    std::optional<json::Node> root_value_;
+    bool requests_failed_ = false;
+
+    bool IsRequestsSection() const {
+        return section_ == Section::BASE_REQUESTS || section_ == Section::STAT_REQUESTS;
+    }
 
-        // Когда запросов несколько, добавляем по одному
-        if (stat_requests_node.IsArray()) {
-            const json::Array& stat_requests_array = stat_requests_node.AsArray();
-            for (const auto& request : stat_requests_array) {
-                // вытаскиваем данные текущей команды
-                const json::Dict& stat_request_map = request.AsDict();
-                AddRequestToRequests(stat_request_map);
+    // Начало значения: корневой словарь и массив запросов разбираются здесь, остальное собирается деревом
+    template <typename Event>
+    void OnValue(ValueKind kind, Event event) {
+        if (!capturing_) {
+            if (depth_ == 0 && kind == ValueKind::DICT) {
+                depth_ = 1;
+                return;
+            }
+            if (depth_ == 1 && IsRequestsSection()) {
+                if (kind == ValueKind::ARRAY) {
+                    depth_ = 2;
+                    return;
+                }
+                if (kind == ValueKind::SCALAR) {
+                    std::cerr << "There is no "s << section_key_ << std::endl;
+                    return;
+                }
             }
+            capturing_ = true;
+            capture_depth_ = depth_;
+        }
+        Forward(event);
+    }
+
+    template <typename Event>
+    void Forward(Event event) {
+        event(builder_);
+        if (builder_.IsComplete()) {
+            capturing_ = false;
+            OnValueCollected(builder_.Extract());
         }
-        // Когда запрос один
-        else if (stat_requests_node.IsDict()) {
-            const json::Dict& stat_request_map = stat_requests_node.AsDict();
-            AddRequestToRequests(stat_request_map);
+    }
+
+    void OnValueCollected(json::Node value) {
+        if (capture_depth_ == 0) {
+            root_value_ = std::move(value);
+        }
+        else if (capture_depth_ == 1 && !IsRequestsSection()) {
+            sections_.insert_or_assign(section_key_, std::move(value));
         }
-        // to do: закомментировать следующий else
         else {
-            std::cerr << "There is no stat_requests" << std::endl;
+            ProcessRequest(value);
         }
     }
-    catch (std::logic_error& e) {
-        std::cerr << "LOG err: from json_reader FormAllRequestsData: main_node is not a map => "s << e.what() << std::endl;
+
+    // Запрос, собранный деревом при разборе событиями (массив из одного запроса)
+    void ProcessRequest(const json::Node& request) {
+        if (section_ == Section::STAT_REQUESTS) {
+            ProcessStatRequests(&request, &request + 1);
+        }
+        else {
+            ProcessBaseRequests(&request, &request + 1);
+        }
     }
-    catch (std::exception& e) {
-        std::cerr << "LOG err: from json_reader FormAllRequestsData: "s << e.what() << std::endl;
+
+    // Раздел base_requests или stat_requests: массив запросов, один запрос-словарь или ошибка
+    template <typename NodeType>
+    void ProcessRequestsSection(std::string_view key, const NodeType& value) {
+        if (!value.IsArray() && !value.IsDict()) {
+            std::cerr << "There is no "s << key << std::endl;
+            return;
+        }
+        if (value.IsArray()) {
+            ProcessRequests(key, value.AsArray().begin(), value.AsArray().end());
+        }
+        else {
+            ProcessRequests(key, &value, &value + 1);
+        }
     }
-// В результате заполнена база запросов
+
+    template <typename Iterator>
+    void ProcessRequests(std::string_view key, Iterator begin, Iterator end) {
+        if (key == "base_requests"sv) {
+            ProcessBaseRequests(begin, end);
+        }
+        else {
+            ProcessStatRequests(begin, end);
+        }
+    }
+
+    template <typename Iterator>
+    void ProcessStatRequests(Iterator begin, Iterator end) {
+        for (Iterator request = begin; request != end && !requests_failed_; ++request) {
+            try {
+                reader_.stat_requests_.push_back(FormRequestDescription(request->AsDict()));
+            }
+            catch (std::exception& e) {
+                OnRequestError(e.what());
+            }
+        }
+    }
+
+    void OnRequestError(std::string_view error) {
+        std::cerr << "LOG err: from json_reader StreamingHandler: "s << error << std::endl;
+        requests_failed_ = true;
+    }
+
+    /*
+    Обрабатывает запросы base_requests из документа-представления или дерева: остановки сразу
+    добавляются в каталог, маршруты - после всех остановок, названия берутся прямо из документа
+    */
+    template <typename Iterator>
+    void ProcessBaseRequests(Iterator begin, Iterator end) {
+        Iterator processed_end = begin;
+        StopRequestView stop;
+        BusRequestView bus;
+        for (; processed_end != end && !requests_failed_; ++processed_end) {
+            try {
+                // маршрут пока только проверяется: он может ссылаться на остановки, описанные позже
+                if (DecodeBaseRequest(processed_end->AsDict(), stop, bus) == BaseRequestKind::STOP) {
+                    AddStopFromView(catalogue_, stop);
+                }
+            }
+            catch (std::exception& e) {
+                OnRequestError(e.what());
+                break;
+            }
+        }
+        for (Iterator request = begin; request != processed_end; ++request) {
+            if (DecodeBaseRequest(request->AsDict(), stop, bus) == BaseRequestKind::BUS) {
+                catalogue_.AddBus(bus.name, bus.stops, bus.is_roundtrip);
+            }
+        }
+    }
+
+    /*
+    Разбирает записи запросов base_requests порциями в пуле потоков тем же DecodeBaseRequest, что и
+    ProcessBaseRequests, и обрабатывает их в порядке документа: остановки сразу добавляются
+    в каталог, маршруты - после всех остановок массива. Для маршрутов до этого хранятся их документы
+    */
+    void ProcessBaseRequestsInParallel(const std::vector<std::string_view>& requests) {
+        parallel::ThreadPool& thread_pool = reader_.GetThreadPool();
+        std::vector<DecodedBaseRequest> decoded_requests;
+        std::vector<DecodedBaseRequest> buses;
+        for (size_t begin = 0; begin < requests.size(); begin += PARALLEL_PARSE_WINDOW_SIZE) {
+            const size_t count = std::min(PARALLEL_PARSE_WINDOW_SIZE, requests.size() - begin);
+            // после ошибочного запроса остальные все равно разбираются: ошибка записи JSON
+            // в любом из них должна прервать загрузку, как при последовательном разборе
+            decoded_requests.clear();
+            decoded_requests.resize(count);
+            thread_pool.ParallelFor(count, [&decoded_requests, &requests, begin](size_t i) {
+                decoded_requests[i] = DecodeBaseRequestText(requests[begin + i]);
+            });
+            for (DecodedBaseRequest& decoded : decoded_requests) {
+                if (requests_failed_) {
+                    break;
+                }
+                if (!decoded.is_valid) {
+                    OnRequestError(decoded.error);
+                    break;
+                }
+                if (decoded.kind == BaseRequestKind::STOP) {
+                    AddStopFromView(catalogue_, decoded.stop);
+                }
+                else {
+                    buses.push_back(std::move(decoded));
+                }
+            }
+        }
+        for (const DecodedBaseRequest& decoded : buses) {
+            catalogue_.AddBus(decoded.bus.name, decoded.bus.stops, decoded.bus.is_roundtrip);
+        }
+    }
+};
+
+bool JsonReader::StreamingHandler::ParseBySections(std::string_view input) {
+    std::vector<std::pair<std::string_view, std::string_view>> sections;
+    std::vector<std::string_view> base_requests;
+    const char* base_requests_value = nullptr;
+    const bool parallel = reader_.threads_count_ > 1 && input.size() >= PARALLEL_PARSE_MIN_SIZE;
+    try {
+        sections = json::SplitDict(input);
+        for (const auto& [key, value] : sections) {
+            // ключ передается как записан, поэтому ключи с экранированием не поддерживаются
+            if (key.find('\\') != std::string_view::npos) {
+                return false;
+            }
+            if (parallel && key == "base_requests"sv && !base_requests_value && !value.empty() && value.front() == '[') {
+                base_requests = json::SplitArray(value);
+                base_requests_value = value.data();
+            }
+        }
+    }
+    catch (const json::ParsingError&) {
+        // корень не словарь или в записи документа ошибка - о ней сообщит последовательный разбор
+        return false;
+    }
+
+    // обработчик получает те же события, что и при разборе всего документа, но без прочих разделов,
+    // а массив base_requests при параллельном разборе приходит уже разобранными запросами
+    StartDict();
+    for (const auto& [key, value] : sections) {
+        if (key != "base_requests"sv && key != "stat_requests"sv) {
+            reader_.lazy_sections_.Add(std::string(key), value);
+            continue;
+        }
+        Key(key);
+        if (key == "base_requests"sv && !value.empty() && value.front() == '[') {
+            StartArray();
+            if (value.data() == base_requests_value) {
+                ProcessBaseRequestsInParallel(base_requests);
+            }
+            else {
+                // строки документа-представления ссылаются на input, который живет до конца загрузки
+                const json::ViewDocument requests = json::LoadView(nullptr, value);
+                const json::ViewArray& requests_array = requests.GetRoot().AsArray();
+                ProcessBaseRequests(requests_array.begin(), requests_array.end());
+            }
+            EndArray();
+        }
+        else {
+            json::Parse(value, *this);
+        }
+    }
+    EndDict();
+    return true;
+}
+
+parallel::ThreadPool& JsonReader::GetThreadPool() {
+    if (!thread_pool_) {
+        // вызывающий поток тоже участвует в работе
+        thread_pool_ = std::make_unique<parallel::ThreadPool>(threads_count_ - 1);
+    }
+    return *thread_pool_;
+}
+
+void JsonReader::ParseBaseDocument(std::string_view input, StreamingHandler& handler) {
+    lazy_sections_ = json::LazyDict{};
+    if (!handler.ParseBySections(input)) {
+        // документ разбирается целиком тем же кодом, что и разделы: строки документа-представления
+        // ссылаются на input, а все, что нужно после разбора, из него копируется
+        const json::ViewDocument document = json::LoadView(nullptr, input);
+        handler.ProcessDocument(document.GetRoot());
+    }
+}
+
+void JsonReader::ApplyCommands(transport::TransportCatalogue& catalogue) {
+    StreamingHandler handler(*this, catalogue);
+    handler.ProcessDocument(document_with_requests_.GetRoot());
+}
+
+// Загрузка базы из потока или файла. Буфер с документом освобождается до Finish: запросы
+// base_requests переводятся в вызовы каталога еще при разборе, а разделы (lazy_sections_) хранят копии строк
+void JsonReader::LoadJsonToCatalogue(std::istream& input, transport::TransportCatalogue& catalogue) {
+    StreamingHandler handler(*this, catalogue);
+    ParseBaseDocument(json::ReadAll(input), handler);
+    handler.Finish();
+}
+
+void JsonReader::LoadJsonFileToCatalogue(const std::string& path, transport::TransportCatalogue& catalogue) {
+    StreamingHandler handler(*this, catalogue);
+    ParseBaseDocument(json::ReadFileContents(path).contents, handler);
+    handler.Finish();
 }
 
+
 // Выводит JSON c ответами
 void JsonReader::PrintResponse(std::ostream& output) const {
     // Проверка, что ответ есть
@@ -394,19 +792,24 @@ void JsonReader::PrintResponse(std::ostream& output) const {
 
 // Обрабатывает один запрос типа Stop и возвращает словарь данных ответа на запрос
 static json::Dict ProcessStopRequest(const RequestHandler& request_handler, const RequestDescription& request) {
-    if (request.type != "Stop") {
+    if (!request.IsStop()) {
         throw std::invalid_argument("Request is not about Stop"s);
     }
     // инициализируем map для ответа на текущий запрос
     // json::Dict response_map({{"request_id"s, json::Node(request.id)}});
     json::Dict response_map;
 
-    std::optional<domain::StopInfo> stop_stat = request_handler.GetBusesByStop(*request.name);
+    // остановка уже найдена по названию, неизвестная остановка - сразу "not found"
+    std::optional<domain::StopInfo> stop_stat;
+    if (request.object_id != UNKNOWN_OBJECT_ID) {
+        stop_stat = request_handler.GetBusesByStopId(request.object_id);
+    }
     
     // случай 1) Остановка найдена:
     if (stop_stat.has_value()) {
         // получаем автобусы и записываем их в map
         json::Array buses_array;
+        buses_array.reserve(stop_stat.value().buses_list.size());
 
         // цикл нужен, чтобы привести к string, т.к. в Node используется тип string
         for (const auto& bus_name : stop_stat.value().buses_list) {
@@ -417,7 +820,7 @@ static json::Dict ProcessStopRequest(const RequestHandler& request_handler, cons
         response_map = json::Builder{}
                                 .StartDict()
                                     .Key("request_id"s).Value(request.id)
-                                    .Key("buses"s).Value(buses_array)
+                                    .Key("buses"s).Value(std::move(buses_array))
                                 .EndDict()
                                 .Build()
                                 .AsDict();
@@ -440,13 +843,17 @@ static json::Dict ProcessStopRequest(const RequestHandler& request_handler, cons
 
 // Обрабатывает один запрос типа Bus и возвращает словарь данных ответа на запрос
 static json::Dict ProcessBusRequest(const RequestHandler& request_handler, const RequestDescription& request) {
-    if (request.type != "Bus") {
+    if (!request.IsBus()) {
         throw std::invalid_argument("Request is not about Bus"s);
     }
     // инициализируем map для ответа на текущий запрос
     json::Dict response_map;
 
-    std::optional<domain::BusInfo> bus_stat = request_handler.GetBusStat(*request.name);
+    // маршрут уже найден по названию, неизвестный маршрут - сразу "not found"
+    std::optional<domain::BusInfo> bus_stat;
+    if (request.object_id != UNKNOWN_OBJECT_ID) {
+        bus_stat = request_handler.GetBusStatById(request.object_id);
+    }
     
     // случай 1) Автобус найден в каталоге:
     if (bus_stat.has_value()) {
@@ -482,15 +889,12 @@ static json::Dict ProcessBusRequest(const RequestHandler& request_handler, const
 
 // Обрабатывает один запрос типа Map и возвращает словарь данных ответа на запрос
 json::Dict JsonReader::ProcessMapRequest(RequestHandler& request_handler, const request_detail::RequestDescription& request) const {
-    if (request.type != "Map") {
+    if (!request.IsMap()) {
         throw std::invalid_argument("Request is not a Map"s);
     }
     // инициализируем map для ответа на текущий запрос
     // json::Dict response_map({{"request_id"s, json::Node(request.id)}});
     json::Dict response_map;
-    
-    // Применяем параметры отображения svg
-    ApplyRenderSettings(request_handler.GetMaprenderer());
 
     // "Рисуем" карту в строковый поток и вычленяем строку 
     std::ostringstream svg_stream;
@@ -500,7 +904,7 @@ json::Dict JsonReader::ProcessMapRequest(RequestHandler& request_handler, const
     response_map = json::Builder{}
                             .StartDict()
                                 .Key("request_id"s).Value(request.id)
-                                .Key("map"s).Value(svg_text)
+                                .Key("map"s).Value(std::move(svg_text))
                             .EndDict()
                             .Build()
                             .AsDict();
@@ -513,13 +917,14 @@ json::Dict JsonReader::ProcessMapRequest(RequestHandler& request_handler, const
 json::Array TransformRouteItemsToJsonArray(const routing::TransportRouteItems& items) {
     using namespace routing;
     json::Array json_items;
+    json_items.reserve(items.size());
 
     for (size_t i = 0; i < items.size(); i++) {
         json::Node node_tmp;
         // шаг 1 - ожидание на остановке
         if (std::holds_alternative<WaitRouteItem>(items[i])) {
             // получаем кусок пути
-            WaitRouteItem wait_item = std::get<WaitRouteItem>(items[i]);
+            const WaitRouteItem& wait_item = std::get<WaitRouteItem>(items[i]);
             node_tmp = json::Builder{}.StartDict()
                                             .Key("type"s).Value(wait_item.type)
                                             .Key("time"s).Value(wait_item.duration)
@@ -531,7 +936,7 @@ json::Array TransformRouteItemsToJsonArray(const routing::TransportRouteItems& i
         // шаг 2 - поездка на автобусе 
         else if (std::holds_alternative<BusRouteItem>(items[i])) {
             // получаем кусок пути
-            BusRouteItem bus_item = std::get<BusRouteItem>(items[i]);
+            const BusRouteItem& bus_item = std::get<BusRouteItem>(items[i]);
             node_tmp = json::Builder{}.StartDict()
                                             .Key("type"s).Value(bus_item.type)
                                             .Key("time"s).Value(bus_item.duration)
@@ -551,18 +956,22 @@ json::Array TransformRouteItemsToJsonArray(const routing::TransportRouteItems& i
 
 json::Dict JsonReader::ProcessRouteRequest(const request_detail::RequestDescription& request) const {
     // std::cout << "LOG start: ProcessRouteRequest ("s << request.id << ")"s << std::endl;
-    using namespace routing;
-    if (request.type != "Route") {
+    if (!request.IsRoute()) {
         throw std::invalid_argument("Request is not a Route"s);
     }
     if (!request.route_from_stop || !request.route_to_stop) {
         throw std::invalid_argument("Request is not a Route"s);
     }
+    if (!router_ptr_) {
+        throw std::logic_error("Router is not built"s);
+    }
+    return ProcessRouteRequest(request, router_ptr_->GetRouteInfo(*request.route_from_stop, *request.route_to_stop));
+}
+
+json::Dict JsonReader::ProcessRouteRequest(const request_detail::RequestDescription& request, const routing::TransportRouteInfo& route_info) const {
     // инициализируем map для ответа на текущий запрос
     json::Dict response_map;
 
-    std::optional<std::pair<TransportRouteItems, Duration>> route_info = router_ptr_->GetRouteInfo(*request.route_from_stop, *request.route_to_stop);
-    
     // случай 1 - путь не найден
     if (!route_info.has_value()) {
         response_map = json::Builder{}.StartDict()
@@ -587,13 +996,13 @@ json::Dict JsonReader::ProcessRouteRequest(const request_detail::RequestDescript
     }
 
     // случай 3 - общий / невырожденный
-    const json::Array& json_route_items = TransformRouteItemsToJsonArray(route_info.value().first);
+    json::Array json_route_items = TransformRouteItemsToJsonArray(route_info.value().first);
 
     response_map = json::Builder{}
                             .StartDict()
                                 .Key("request_id"s).Value(request.id)
                                 .Key("total_time"s).Value(route_info.value().second)
-                                .Key("items"s).Value(json_route_items)
+                                .Key("items"s).Value(std::move(json_route_items))
                             .EndDict()
                             .Build()
                             .AsDict();
@@ -602,25 +1011,154 @@ json::Dict JsonReader::ProcessRouteRequest(const request_detail::RequestDescript
 }
 
 
+// Преобразует список названий в json::Array
+static json::Array TransformNamesToJsonArray(const std::vector<std::string_view>& names) {
+    json::Array names_array;
+    names_array.reserve(names.size());
+    for (std::string_view name : names) {
+        names_array.emplace_back(std::string(name));
+    }
+    return names_array;
+}
+
+json::Dict JsonReader::ProcessSuggestRequest(const request_detail::RequestDescription& request) const {
+    if (!request.IsSuggest() || !request.query) {
+        throw std::invalid_argument("Request is not a Suggest"s);
+    }
+    if (!name_index_ptr_) {
+        throw std::logic_error("Name index is not built"s);
+    }
+    search::Suggestions suggestions = name_index_ptr_->Suggest(*request.query, request.limit, request.max_typos);
+
+    return json::Builder{}
+                .StartDict()
+                    .Key("request_id"s).Value(request.id)
+                    .Key("stops"s).Value(TransformNamesToJsonArray(suggestions.stops))
+                    .Key("buses"s).Value(TransformNamesToJsonArray(suggestions.buses))
+                .EndDict()
+                .Build()
+                .AsDict();
+}
+
+
 // Обрабатывает один запрос и возвращает словарь данных ответа на запрос
 json::Dict JsonReader::ProcessOneRequest(RequestHandler& request_handler, const RequestDescription& request) const {
-    json::Dict response_map;
-    if (request.IsStop() /* request.type == "Stop" */) {
-        response_map = ProcessStopRequest(request_handler, request);
+    switch (request.type) {
+        case RequestType::STOP:
+            return ProcessStopRequest(request_handler, request);
+        case RequestType::BUS:
+            return ProcessBusRequest(request_handler, request);
+        case RequestType::MAP:
+            return ProcessMapRequest(request_handler, request);
+        case RequestType::ROUTE:
+            return ProcessRouteRequest(request);
+        case RequestType::SUGGEST:
+            return ProcessSuggestRequest(request);
+        case RequestType::UNKNOWN:
+            break;
     }
-    else if (request.IsBus() /* request.type == "Bus" */) {
-        response_map = ProcessBusRequest(request_handler, request);
+    return {};
+}
+
+/*
+Записывает ответ так, как его выводит ProcessRequestsAndPrintResponse - элементом массива ответов,
+и вырезает значение request_id (в response оно должно быть равно 0)
+*/
+static SerializedResponse SerializeResponse(const json::Dict& response) {
+    std::ostringstream stream;
+    {
+        json::Writer writer(stream);
+        writer.StartArray().Value(response).EndArray();
     }
-    else if (request.IsMap() /* request.type == "Map" */) {
-        response_map = ProcessMapRequest(request_handler, request);
+    const std::string array_text = stream.str();
+    // ответ - словарь внутри массива: от первой открывающей до последней закрывающей скобки
+    const size_t begin = array_text.find('{');
+    const size_t end = array_text.rfind('}');
+    if (begin == std::string::npos || end == std::string::npos) {
+        throw std::logic_error("LOG err: in SerializeResponse - response is not a Dict"s);
     }
-    else if (request.IsRoute()) {
-        response_map = ProcessRouteRequest(request);
+    SerializedResponse serialized;
+    serialized.text = array_text.substr(begin, end - begin + 1);
+    // внутри строк кавычки экранированы, поэтому ключ с двоеточием встречается только как ключ
+    static const std::string_view id_marker = "\"request_id\": 0"sv;
+    const size_t marker_pos = serialized.text.find(id_marker);
+    if (marker_pos == std::string::npos) {
+        throw std::logic_error("LOG err: in SerializeResponse - no request_id in response"s);
     }
-    return response_map;
+    serialized.id_pos = marker_pos + id_marker.size() - 1;
+    serialized.text.erase(serialized.id_pos, 1);
+    return serialized;
 }
 
-// Вспомогательная функция для GetRoutingSettingsFromDocument 
+/*
+Ответы на запросы Stop и Bus зависят только от каталога, который не меняется во время обработки запросов,
+поэтому для каждой остановки и маршрута ответ записывается в JSON один раз (в пуле потоков, если он есть),
+а при выводе в него только вставляется номер запроса
+*/
+void JsonReader::PrepareResponseCache(const RequestHandler& request_handler) {
+    // по одному запросу на каждую остановку и маршрут
+    std::vector<RequestDescription> requests_to_serialize;
+    std::vector<bool> stop_queued;
+    std::vector<bool> bus_queued;
+    for (const RequestDescription& request : stat_requests_) {
+        if ((!request.IsStop() && !request.IsBus()) || request.object_id == UNKNOWN_OBJECT_ID) {
+            continue;
+        }
+        std::vector<bool>& queued = request.IsStop() ? stop_queued : bus_queued;
+        if (queued.size() <= request.object_id) {
+            queued.resize(request.object_id + 1);
+        }
+        if (queued[request.object_id]) {
+            continue;
+        }
+        queued[request.object_id] = true;
+        RequestDescription object_request;
+        object_request.type = request.type;
+        object_request.object_id = request.object_id;
+        requests_to_serialize.push_back(std::move(object_request));
+    }
+    stop_responses_.assign(stop_queued.size(), {});
+    bus_responses_.assign(bus_queued.size(), {});
+
+    // разные запросы пишут в разные ячейки, поэтому их можно записывать параллельно
+    auto serialize_request = [&](size_t i) {
+        const RequestDescription& request = requests_to_serialize[i];
+        if (request.IsStop()) {
+            stop_responses_[request.object_id] = SerializeResponse(ProcessStopRequest(request_handler, request));
+        }
+        else {
+            bus_responses_[request.object_id] = SerializeResponse(ProcessBusRequest(request_handler, request));
+        }
+    };
+    if (thread_pool_) {
+        thread_pool_->ParallelFor(requests_to_serialize.size(), serialize_request);
+    }
+    else {
+        for (size_t i = 0; i < requests_to_serialize.size(); ++i) {
+            serialize_request(i);
+        }
+    }
+
+    RequestDescription unknown_request;
+    unknown_request.type = RequestType::STOP;
+    not_found_response_ = SerializeResponse(ProcessStopRequest(request_handler, unknown_request));
+}
+
+const SerializedResponse* JsonReader::FindCachedResponse(const RequestDescription& request) const {
+    if (not_found_response_.text.empty() || (!request.IsStop() && !request.IsBus())) {
+        return nullptr;
+    }
+    if (request.object_id == UNKNOWN_OBJECT_ID) {
+        return &not_found_response_;
+    }
+    const std::vector<SerializedResponse>& responses = request.IsStop() ? stop_responses_ : bus_responses_;
+    if (request.object_id >= responses.size() || responses[request.object_id].text.empty()) {
+        return nullptr;
+    }
+    return &responses[request.object_id];
+}
+
+// Вспомогательная функция для GetRoutingSettingsFromSection 
 // для извлечения параметров построения маршрута из словаря json::Dict
 routing::RoutingSettings ParseRoutingParameters(const json::Dict& settings_map) {
     routing::RoutingSettings routing_options;
@@ -642,58 +1180,109 @@ routing::RoutingSettings ParseRoutingParameters(const json::Dict& settings_map)
     return routing_options; 
 }
 
-// Возвращает параметры построения маршрута, обнаруженные в json-документе
-routing::RoutingSettings GetRoutingSettingsFromDocument (const json::Document& document) {
+// Возвращает параметры построения маршрута из раздела routing_settings
+// (settings_node == nullptr, если раздела в документе нет)
+static routing::RoutingSettings GetRoutingSettingsFromSection(const json::Node* settings_node) {
     // Создаем структуру, которую будем заполнять значениями из документа
     // По умолчанию она заполнена некоторыми адекватными значениями
     routing::RoutingSettings routing_params;
+    if (!settings_node) {
+        std::cerr << "There is no routing_settings. Default routing options will be used!"sv << std::endl;
+        return routing_params;
+    }
     try {
-        // 0. Получаем map запросов
-        if (!document.GetRoot().IsDict()) {
-            std::cerr << "LOG err: in GetRoutingSettingsFromDocument document.GetRoot() is not a map! \n Default routing options will be used!"sv << std::endl;
-            return routing_params;
-        }
-
-        const json::Dict& main_node = document.GetRoot().AsDict();
-        
-        // 1. Парсим запросы "routing_settings"
-        const json::Node& route_settings_node = main_node.at("routing_settings");
-        
-        // Проверяем, что render_settings правильно считалась как map
-        if (!route_settings_node.IsDict()) {
+        // Проверяем, что routing_settings правильно считалась как map
+        if (!settings_node->IsDict()) {
             std::cerr << "There is no routing_settings" << std::endl;
         }
-        // 2. Получаем словарь параметров
-        const json::Dict& settings_map = route_settings_node.AsDict(); 
+        // Получаем словарь параметров
+        const json::Dict& settings_map = settings_node->AsDict(); 
 
-        // 3. Поэлементно добавляем в структуру параметров параметры из json-документа
+        // Поэлементно добавляем в структуру параметров параметры из json-документа
         routing_params = ParseRoutingParameters(settings_map);  
     }
-    catch (std::logic_error& e) {
-        std::cerr << "LOG err: from json_reader GetRenderSettingsFromDocument: main_node is not a map => "s << e.what() << std::endl;
-    }
     catch (std::exception& e) {
-        std::cerr << "LOG err: from json_reader GetRenderSettingsFromDocument: "s << e.what() << std::endl;
+        std::cerr << "LOG err: from json_reader GetRoutingSettingsFromSection: "s << e.what() << std::endl;
     }
 
     return routing_params;
 }
 
+const json::Node* JsonReader::FindSection(std::string_view key) const {
+    if (const json::Node* section = lazy_sections_.Find(key)) {
+        return section;
+    }
+    const json::Node& root = document_with_requests_.GetRoot();
+    if (!root.IsDict()) {
+        return nullptr;
+    }
+    const auto it = root.AsDict().find(key);
+    return it == root.AsDict().end() ? nullptr : &it->second;
+}
+
 
 void JsonReader::BuildRouterForRouteRequests(RequestHandler& request_handler) {
     using namespace routing;
-    RoutingSettings routing_settings = GetRoutingSettingsFromDocument(document_with_requests_);
+    RoutingSettings routing_settings = GetRoutingSettingsFromSection(FindSection("routing_settings"sv));
     // сроим граф
     TransportGraphMaker graph_maker(request_handler.GetTransportCatalogue(), routing_settings);
-    std::unique_ptr<TransportRouter> router_ptr_tmp = std::make_unique<TransportRouter>(std::move(graph_maker));
+    std::unique_ptr<TransportRouter> router_ptr_tmp = std::make_unique<TransportRouter>(std::move(graph_maker), router_mode_);
     router_ptr_ = std::move(router_ptr_tmp);
+    // маршрутизатор обновляется вместе с каталогом
+    request_handler.SetRouter(router_ptr_.get());
+}
+
+std::vector<routing::TransportRouteInfo> JsonReader::FindRoutesForRouteRequests(const RequestHandler& request_handler) {
+    std::vector<routing::RouteQuery> queries;
+    for (size_t i = 0; i < stat_requests_.size(); ++i) {
+        const RequestDescription& request = stat_requests_[i];
+        // маршрут ищется один раз для всех одинаковых запросов
+        if (!request.IsRoute() || first_same_requests_[i] != i) {
+            continue;
+        }
+        if (!request.route_from_stop || !request.route_to_stop) {
+            throw std::invalid_argument("Request is not a Route"s);
+        }
+        queries.emplace_back(*request.route_from_stop, *request.route_to_stop);
+    }
+    if (queries.empty()) {
+        return {};
+    }
+    return request_handler.GetRoutes(queries, thread_pool_.get());
+}
+
+// Строит индекс названий: вес остановки - число проходящих через неё автобусов,
+// вес маршрута - число его уникальных остановок
+void JsonReader::BuildNameIndexForSuggestRequests(const RequestHandler& request_handler) {
+    std::vector<search::WeightedName> stop_names;
+    for (const domain::Stop* stop : request_handler.GetTransportCatalogue().GetAllStops()) {
+        const std::optional<domain::StopInfo> stop_info = request_handler.GetBusesByStop(stop->name);
+        const size_t buses_count = stop_info ? stop_info->buses_list.size() : 0;
+        stop_names.push_back({stop->name, static_cast<uint32_t>(buses_count)});
+    }
+
+    std::vector<search::WeightedName> bus_names;
+    for (const auto& [bus_name, bus_ptr] : request_handler.GetAllBusesForMap()) {
+        bus_names.push_back({bus_name, bus_ptr->unique_stops_count});
+    }
+
+    name_index_ptr_ = std::make_unique<search::NameIndex>(std::move(stop_names), std::move(bus_names));
 }
 
 /**
  * Отправляет запросы к транспортному каталогу, 
  * принимает ответы и формирует json::Document 
 */
-const json::Document& JsonReader::ProcessRequestsAndGetResponse(RequestHandler& request_handler) {
+void JsonReader::PrepareForBatchRequests(RequestHandler& request_handler) {
+    stop_responses_.clear();
+    bus_responses_.clear();
+    not_found_response_ = {};
+    // Остановки и маршруты запросов ищутся по названиям один раз, когда каталог заполнен:
+    // при потоковой загрузке запросы могут прийти раньше базы
+    for (RequestDescription& request : stat_requests_) {
+        ResolveRequestObject(request_handler.GetTransportCatalogue(), request);
+    }
+    DeduplicateRequests();
     // При наличии запросов на маршруты создаем router 
     const auto it = std::find_if(stat_requests_.begin(), stat_requests_.end(), 
                             [](const RequestDescription& req) {
@@ -702,25 +1291,245 @@ const json::Document& JsonReader::ProcessRequestsAndGetResponse(RequestHandler&
     if (it != stat_requests_.end()) {
         BuildRouterForRouteRequests(request_handler);
     }
+    // При наличии запросов подсказок строим индекс названий
+    if (std::any_of(stat_requests_.begin(), stat_requests_.end(), [](const RequestDescription& req) {
+            return req.IsSuggest();
+        })) {
+        BuildNameIndexForSuggestRequests(request_handler);
+    }
+    // При наличии запросов карты один раз применяем параметры отображения svg: 
+    // отрисованные слои карты переиспользуются между запросами
+    if (std::any_of(stat_requests_.begin(), stat_requests_.end(), [](const RequestDescription& req) {
+            return req.IsMap();
+        })) {
+        ApplyRenderSettings(request_handler.GetMaprenderer());
+    }
+    if (!stat_requests_.empty() && threads_count_ > 1) {
+        GetThreadPool();
+    }
+}
+
+void JsonReader::ProcessBatchRequests(RequestHandler& request_handler, size_t window_size,
+                                      const std::function<void(const RequestDescription&, json::Dict)>& on_response) {
+    // маршруты ищем сразу для всех запросов: запросы с общей остановкой отправления обрабатываются вместе
+    const std::vector<routing::TransportRouteInfo> routes_info = FindRoutesForRouteRequests(request_handler);
+    // номер ответа на каждый запрос маршрута в routes_info (только для первого из одинаковых запросов)
+    std::vector<size_t> route_indexes(stat_requests_.size());
+    for (size_t i = 0, route_ind = 0; i < stat_requests_.size(); ++i) {
+        if (stat_requests_[i].IsRoute() && first_same_requests_[i] == i) {
+            route_indexes[i] = route_ind++;
+        }
+    }
+    // номер последнего из одинаковых запросов: до него ответ на первый запрос хранится в same_responses
+    std::vector<size_t> last_same_requests(stat_requests_.size());
+    for (size_t i = 0; i < stat_requests_.size(); ++i) {
+        last_same_requests[first_same_requests_[i]] = i;
+    }
+    std::unordered_map<size_t, json::Dict> same_responses;
+
+    // Каждый ответ порции записывается в свою ячейку, поэтому порядок ответов не зависит от порядка обработки
+    std::vector<json::Dict> responses;
+    for (size_t begin = 0; begin < stat_requests_.size(); begin += window_size) {
+        responses.resize(std::min(window_size, stat_requests_.size() - begin));
+        auto process_request = [&](size_t j) {
+            const size_t i = begin + j;
+            const RequestDescription& request_cur = stat_requests_[i];
+            // на повторный запрос отвечаем копией ответа на первый такой же запрос (см. ниже)
+            if (FindCachedResponse(request_cur) || first_same_requests_[i] != i) {
+                return;
+            }
+            if (request_cur.IsRoute()) {
+                responses[j] = ProcessRouteRequest(request_cur, routes_info.at(route_indexes[i]));
+                return;
+            }
+            responses[j] = ProcessOneRequest(request_handler, request_cur);
+        };
+        if (thread_pool_) {
+            thread_pool_->ParallelFor(responses.size(), process_request);
+        }
+        else {
+            for (size_t j = 0; j < responses.size(); ++j) {
+                process_request(j);
+            }
+        }
+        for (size_t j = 0; j < responses.size(); ++j) {
+            const size_t i = begin + j;
+            const size_t first_ind = first_same_requests_[i];
+            const size_t last_ind = last_same_requests[first_ind];
+            if (FindCachedResponse(stat_requests_[i]) || first_ind == last_ind) {
+                on_response(stat_requests_[i], std::move(responses[j]));
+                continue;
+            }
+            json::Dict response;
+            if (i == first_ind) {
+                same_responses.emplace(i, responses[j]);
+                response = std::move(responses[j]);
+            }
+            else {
+                const auto it = same_responses.find(first_ind);
+                // последнему из одинаковых запросов хранимый ответ отдается целиком
+                if (i == last_ind) {
+                    response = std::move(it->second);
+                    same_responses.erase(it);
+                }
+                else {
+                    response = it->second;
+                }
+                // у ответа на запрос неизвестного типа номера запроса нет
+                const auto id_it = response.find("request_id"sv);
+                if (id_it != response.end()) {
+                    id_it->second = json::Node(stat_requests_[i].id);
+                }
+            }
+            on_response(stat_requests_[i], std::move(response));
+        }
+    }
+}
+
+/*
+Запись запроса, по которой сравниваются запросы: у запросов с одинаковой записью одинаковые ответы
+(кроме request_id). Остановки и маршруты запросов Stop и Bus сравниваются по id в каталоге
+*/
+static std::string MakeRequestKey(const RequestDescription& request) {
+    std::string key(1, static_cast<char>(request.type));
+    switch (request.type) {
+        case RequestType::STOP:
+        case RequestType::BUS:
+            key.append(std::to_string(request.object_id));
+            break;
+        case RequestType::ROUTE:
+            key.append(request.route_from_stop.value_or(""s)).push_back('\0');
+            key.append(request.route_to_stop.value_or(""s));
+            break;
+        case RequestType::SUGGEST:
+            key.append(std::to_string(request.limit)).push_back('\0');
+            key.append(std::to_string(request.max_typos)).push_back('\0');
+            key.append(request.query.value_or(""s));
+            break;
+        case RequestType::MAP:
+        case RequestType::UNKNOWN:
+            break;
+    }
+    return key;
+}
+
+/*
+Находит одинаковые запросы в stat_requests_: каждый различный запрос обрабатывается один раз,
+а остальные такие же запросы получают копию ответа со своим номером
+*/
+void JsonReader::DeduplicateRequests() {
+    first_same_requests_.resize(stat_requests_.size());
+    std::unordered_map<std::string, size_t> first_requests;
+    first_requests.reserve(stat_requests_.size());
+    for (size_t i = 0; i < stat_requests_.size(); ++i) {
+        first_same_requests_[i] = first_requests.emplace(MakeRequestKey(stat_requests_[i]), i).first->second;
+    }
+    batch_stats_.requests_count = stat_requests_.size();
+    batch_stats_.distinct_requests_count = first_requests.size();
+}
+
+const JsonReader::BatchStats& JsonReader::GetBatchStats() const {
+    return batch_stats_;
+}
+
+const json::Document& JsonReader::ProcessRequestsAndGetResponse(RequestHandler& request_handler) {
+    PrepareForBatchRequests(request_handler);
     
     // проверяем, есть ли запросы к базе:
     if (stat_requests_.size() == 0) {
         response_document_ = json::Document(json::Builder{}.Value("null"s).Build());
         return response_document_;
     }
-    else if (stat_requests_.size() >= 1) {
-        json::Array response_array;
-        for (const auto& request_cur : stat_requests_) {
-            const json::Dict& response_map_cur = ProcessOneRequest(request_handler, request_cur);
-            response_array.emplace_back(response_map_cur);
-        }
-        // актуализируем документ ответов 
-        response_document_ = json::Document(json::Builder{}.Value(response_array).Build());
-        
-    }
+    json::Array response_array;
+    response_array.reserve(stat_requests_.size());
+    ProcessBatchRequests(request_handler, stat_requests_.size(), [&response_array](const RequestDescription&, json::Dict response) {
+        response_array.emplace_back(std::move(response));
+    });
+    // актуализируем документ ответов 
+    response_document_ = json::Document(json::Node(std::move(response_array)));
     // возвращаем измененный документ с ответами
     return response_document_;
 }
 
+void JsonReader::ProcessRequestsAndPrintResponse(RequestHandler& request_handler, std::ostream& output) {
+    PrepareForBatchRequests(request_handler);
+
+    json::Writer writer(output);
+    if (stat_requests_.empty()) {
+        writer.Value("null"sv);
+        return;
+    }
+    if (response_cache_enabled_) {
+        PrepareResponseCache(request_handler);
+    }
+    writer.StartArray();
+    // без пула потоков каждый ответ выводится сразу, с пулом - порциями, которые обрабатываются параллельно
+    const size_t window_size = thread_pool_ ? RESPONSES_WINDOW_SIZE : 1;
+    ProcessBatchRequests(request_handler, window_size, [this, &writer](const RequestDescription& request, json::Dict response) {
+        const SerializedResponse* cached_response = FindCachedResponse(request);
+        if (!cached_response) {
+            writer.Value(response);
+            return;
+        }
+        // номер запроса вставляется в записанный ответ
+        char id_chars[16];
+        const auto result = std::to_chars(id_chars, id_chars + sizeof(id_chars), request.id);
+        const std::string_view text = cached_response->text;
+        writer.RawValue({text.substr(0, cached_response->id_pos),
+                         std::string_view(id_chars, result.ptr - id_chars),
+                         text.substr(cached_response->id_pos)});
+    });
+    writer.EndArray();
+}
+
 
+// Готовит всё, что нужно для ответов на любые запросы: маршрутизатор, индекс названий, параметры карты.
+// В отличие от пакетной обработки, заранее неизвестно, какие запросы придут
+void JsonReader::PrepareForSingleRequests(RequestHandler& request_handler) {
+    BuildRouterForRouteRequests(request_handler);
+    BuildNameIndexForSuggestRequests(request_handler);
+    ApplyRenderSettings(request_handler.GetMaprenderer());
+}
+
+// Формирует ответ об ошибке: с номером запроса, если его удалось прочитать
+static json::Dict MakeErrorResponse(const json::Node& request_node, const std::string& message) {
+    json::Dict response_map;
+    if (request_node.IsDict()) {
+        const json::Dict& request_map = request_node.AsDict();
+        const auto id_it = request_map.find("id"s);
+        if (id_it != request_map.end() && id_it->second.IsInt()) {
+            response_map.emplace("request_id"s, id_it->second.AsInt());
+        }
+    }
+    response_map.emplace("error_message"s, message);
+    return response_map;
+}
 
+/**
+ * Обрабатывает один запрос stat_request, записанный строкой JSON,
+ * и возвращает ответ одной строкой JSON (без перевода строки)
+*/
+std::string JsonReader::ProcessRequestLine(RequestHandler& request_handler, const std::string& line) const {
+    json::Node request_node;
+    json::Dict response_map;
+    try {
+        request_node = json::Load(std::string_view(line)).GetRoot();
+        RequestDescription request = FormRequestDescription(request_node.AsDict());
+        if ((request.IsStop() || request.IsBus()) && !request.name) {
+            throw std::invalid_argument("no name in request"s);
+        }
+        ResolveRequestObject(request_handler.GetTransportCatalogue(), request);
+        response_map = ProcessOneRequest(request_handler, request);
+        if (response_map.empty()) {
+            response_map = MakeErrorResponse(request_node, "unknown request type"s);
+        }
+    }
+    catch (std::exception& e) {
+        std::cerr << "LOG err: in JsonReader::ProcessRequestLine: "s << e.what() << std::endl;
+        response_map = MakeErrorResponse(request_node, "bad request"s);
+    }
+
+    std::ostringstream response_stream;
+    json::PrintCompact(json::Document(json::Node(std::move(response_map))), response_stream);
+    return response_stream.str();
+}
@@ -4,12 +4,19 @@
 #include "request_handler.h"
 #include "json.h"
 #include "json_builder.h"
+#include "json_writer.h"
+#include "name_index.h"
 #include "transport_router.h"
+#include "thread_pool.h"
 
+#include <cstdint>
+#include <functional>
+#include <limits>
 #include <optional>
 #include <vector>
 #include <sstream>
 #include <string>
+#include <string_view>
 
 /*
  * Здесь можно разместить код наполнения транспортного справочника данными из JSON,
@@ -19,124 +26,26 @@ namespace request_detail {
 
 using namespace std::literals;
 
-class CommandDescription {
-public:
-    virtual ~CommandDescription() = default;
-    // Определяет, задана ли команда (поле command непустое)
-    explicit operator bool() const {
-        return !command_type_.empty();
-    }
-
-    bool operator!() const {
-        return !operator bool();
-    }
-
-    virtual std::string GetCommandType() const {
-        return command_type_;
-    }
-
-    virtual CommandDescription& SetCommandType(std::string type) {
-        command_type_ = std::move(type);
-        return *this;
-    }
-
-    std::string GetName() const {
-        return name_;
-    }
-
-    CommandDescription& SetName(std::string name) {
-        name_ = std::move(name);
-        return *this;
-    }
-
-private:
-    std::string command_type_;      // Название команды
-    std::string name_;           // название маршрута или остановки
-};
-
-
-class StopCommand final : public CommandDescription {
-public:
-
-    std::string GetCommandType() const override {
-        return command_type_;
-    }
-
-    geo::Coordinates GetCoordinates() const { 
-        return coordinates_; 
-    } 
-    
-    StopCommand& SetCoordinates(double latitude, double longitude) {
-        coordinates_.lat = latitude;
-        coordinates_.lng = longitude;
-        return *this;
-    }
-
-    const std::vector<std::pair<std::string, int>>& GetDistances() const { return road_distances_; }
-
-    StopCommand& SetDistances(std::vector<std::pair<std::string, int>> stop_and_distances) {
-        road_distances_ = std::move(stop_and_distances);
-        return *this;
-    }
-
-    StopCommand& AddDistance(std::string stop_name, int distance) {
-        road_distances_.push_back(std::move(std::make_pair(stop_name, distance)));
-        return *this;
-    }
-
-private:
-    std::string command_type_ = "Stop"s;
-    geo::Coordinates coordinates_;
-    std::vector<std::pair<std::string, int>> road_distances_;
+// Тип запроса stat_request
+enum class RequestType : uint8_t {
+    UNKNOWN,
+    STOP,
+    BUS,
+    MAP,
+    ROUTE,
+    SUGGEST,
 };
 
+// Возвращает тип запроса по его названию (UNKNOWN - неизвестный тип)
+RequestType ParseRequestType(std::string_view type_name);
 
-class BusCommand final : public CommandDescription {
-public:
-    std::string GetCommandType() const override {
-        return command_type_;
-    }
-
-    bool IsRoundTrip() const {
-        return is_round_;
-    }
-
-
-    const std::vector<std::string>& GetStops() const {
-        return stops_;
-    } 
-
-
-    void SetStops(std::vector<std::string> stops) {
-        stops_ = stops;
-    } 
-
-
-    void AddStop(std::string stop_name) {
-        stops_.push_back(stop_name);
-    }
-    
-
-    void SetRoundTrip() {
-        is_round_ = true;
-    }
-
-    void SetStraightTrip() {
-        is_round_ = false;
-    }
-
-private:
-    bool is_round_ = false;
-    std::string command_type_ = "Bus"s;
-    // std::vector<std::string_view> stops_;
-    std::vector<std::string> stops_;
-};
-
+// id объекта запроса, если остановка или маршрут не найдены в каталоге
+inline constexpr uint32_t UNKNOWN_OBJECT_ID = std::numeric_limits<uint32_t>::max();
 
 struct RequestDescription {
-    // Определяет, задана ли команда (поле command непустое)
+    // Определяет, задан ли известный тип запроса
     explicit operator bool() const {
-        return !type.empty();
+        return type != RequestType::UNKNOWN;
     }
 
     bool operator!() const {
@@ -144,29 +53,44 @@ struct RequestDescription {
     }
 
     bool IsRoute() const {
-        return (type == "Route"s);
+        return type == RequestType::ROUTE;
     }
 
     bool IsMap() const {
-        return (type == "Map"s);
+        return type == RequestType::MAP;
     }
 
     bool IsBus() const {
-        return (type == "Bus"s);
+        return type == RequestType::BUS;
     }
 
     bool IsStop() const {
-        return (type == "Stop"s);
+        return type == RequestType::STOP;
     }
 
+    bool IsSuggest() const {
+        return type == RequestType::SUGGEST;
+    }
 
 
-    std::string type;      // Название команды
-    std::optional<std::string> name;      // название маршрута или остановки для запросов Bus и Ыещз
-    int id;                // id (номер) запроса
+    RequestType type = RequestType::UNKNOWN;  // Тип запроса
+    int id = 0;                               // id (номер) запроса
+    // для запросов Stop и Bus - id остановки или маршрута в каталоге, находится по name один раз
+    // до обработки запросов (см. ResolveRequestObject), UNKNOWN_OBJECT_ID - объект не найден
+    uint32_t object_id = UNKNOWN_OBJECT_ID;
+    std::optional<std::string> name;      // название маршрута или остановки для запросов Bus и Stop
     std::optional<std::string> route_from_stop; // для запроса маршрута - начальная остановка
     std::optional<std::string> route_to_stop;   // для запроса маршрута - конечная остановка
+    std::optional<std::string> query;           // для запроса подсказок - введенная строка
+    size_t limit = 10;                          // для запроса подсказок - максимум имен в каждом списке
+    size_t max_typos = 0;                       // для запроса подсказок - допустимое число опечаток
+
+};
 
+// Ответ на запрос, заранее записанный в JSON без номера запроса: при выводе номер вставляется в позицию id_pos
+struct SerializedResponse {
+    std::string text;
+    size_t id_pos = 0;
 };
 
 }  // namespace request_detail
@@ -178,11 +102,41 @@ public:
     // Загружает Json в данный класс
     void LoadJson(std::istream& input);
 
+    // Загружает Json из файла (файл отображается в память)
+    void LoadJsonFile(const std::string& path);
+
+    /*
+    Читает JSON с базой потоком событий, не строя документ целиком (заменяет LoadJson и ApplyCommands).
+    Остановки из base_requests сразу добавляются в каталог, маршруты - после всех остановок,
+    запросы stat_requests сохраняются в список запросов, а деревом собираются только
+    остальные разделы (render_settings, routing_settings)
+    */
+    void LoadJsonToCatalogue(std::istream& input, transport::TransportCatalogue& catalogue);
+
+    // То же для файла (файл отображается в память)
+    void LoadJsonFileToCatalogue(const std::string& path, transport::TransportCatalogue& catalogue);
+
     // Выводит JSON c ответами
     void PrintResponse(std::ostream& output) const;
 
+    // Задает число потоков для обработки запросов stat_requests (1 - последовательная обработка).
+    // Результат не зависит от числа потоков
+    void SetThreadsCount(size_t threads_count);
+
+    // Включает вывод ответов на запросы Stop и Bus из заранее записанных фрагментов JSON
+    // в ProcessRequestsAndPrintResponse (по умолчанию включен). Результат от этого не зависит
+    void SetResponseCacheEnabled(bool enabled);
+
+    // Задает режим маршрутизатора для запросов Route (по умолчанию ALL_PAIRS - таблица путей между всеми
+    // парами вершин). В режиме SINGLE_SOURCE таблица не строится, а пути ищутся из каждой остановки
+    // отправления: это быстрее, если отправлений мало. Время маршрутов от режима не зависит, но из
+    // нескольких маршрутов с одинаковым временем режимы могут выбрать разные
+    void SetRouterMode(graph::RouterMode mode);
+
     /**
-     * Наполняет данными транспортный справочник, используя команды из commands_
+     * Наполняет данными транспортный справочник по документу, загруженному LoadJson или LoadJsonFile:
+     * запросы base_requests обрабатываются так же, как в LoadJsonToCatalogue, запросы stat_requests
+     * сохраняются в список запросов
     */
     void ApplyCommands(transport::TransportCatalogue& catalogue);
 
@@ -195,31 +149,88 @@ public:
     // const json::Document& ProcessRequestsAndGetResponse(transport::TransportCatalogue& catalogue);
     const json::Document& ProcessRequestsAndGetResponse(RequestHandler& request_handler);
 
+    /**
+     * Отправляет запросы к транспортному каталогу и выводит ответы в поток по мере готовности,
+     * не собирая документ с ответами (вывод совпадает с ProcessRequestsAndGetResponse и PrintResponse).
+     * В памяти одновременно находятся ответы только на одну порцию запросов
+    */
+    void ProcessRequestsAndPrintResponse(RequestHandler& request_handler, std::ostream& output);
+
+    // Статистика последней обработки запросов stat_requests
+    struct BatchStats {
+        size_t requests_count = 0;           // всего запросов
+        size_t distinct_requests_count = 0;  // различных запросов: одинаковые запросы обрабатываются один раз
+
+        // Во сколько раз запросов больше, чем различных запросов
+        double GetDedupRatio() const {
+            return distinct_requests_count == 0 ? 1.0 : static_cast<double>(requests_count) / distinct_requests_count;
+        }
+    };
+
+    const BatchStats& GetBatchStats() const;
+
+    // Режим сервера: один раз строит маршрутизатор и индекс названий и применяет параметры карты,
+    // после чего можно отвечать на отдельные запросы через ProcessRequestLine
+    void PrepareForSingleRequests(RequestHandler& request_handler);
+
+    // Обрабатывает один запрос stat_request, записанный строкой JSON, и возвращает ответ одной строкой JSON.
+    // Если запрос не удалось разобрать, ответ содержит error_message
+    std::string ProcessRequestLine(RequestHandler& request_handler, const std::string& line) const;
+
 
 private:
+    // Обработчик событий разбора для LoadJsonToCatalogue
+    class StreamingHandler;
+
     json::Document document_with_requests_ = json::Document(json::Node());
+    // Разделы документа с базой, кроме запросов, при загрузке через LoadJsonToCatalogue:
+    // разбираются при первом обращении (см. FindSection)
+    json::LazyDict lazy_sections_;
     json::Document response_document_ = json::Document(json::Node());
     
-    std::vector<request_detail::StopCommand> stop_commands_;
-    std::vector<request_detail::BusCommand> bus_commands_;
     std::vector<request_detail::RequestDescription> stat_requests_;
+    // для каждого запроса stat_requests_ - номер первого такого же запроса (см. DeduplicateRequests)
+    std::vector<size_t> first_same_requests_;
+    BatchStats batch_stats_;
 
     std::unique_ptr<routing::TransportRouter> router_ptr_;
     // routing::TransportRouter router_ptr_;
+    std::unique_ptr<search::NameIndex> name_index_ptr_;
+
+    // Сколько ответов вычисляется параллельно перед выводом при потоковой обработке запросов
+    static constexpr size_t RESPONSES_WINDOW_SIZE = 256;
+    // С какого размера документ с базой разбирается в несколько потоков
+    static constexpr size_t PARALLEL_PARSE_MIN_SIZE = 1024 * 1024;
+    // Сколько запросов base_requests разбирается параллельно перед добавлением в каталог
+    // (документы разобранных запросов порции хранятся до ее обработки)
+    static constexpr size_t PARALLEL_PARSE_WINDOW_SIZE = 4096;
+
+    size_t threads_count_ = 1;
+    graph::RouterMode router_mode_ = graph::RouterMode::ALL_PAIRS;
+
+    // Ответы на запросы Stop и Bus, записанные в JSON один раз на остановку или маршрут
+    // (см. PrepareResponseCache), индекс - id остановки или маршрута. Пустой text - ответа нет
+    bool response_cache_enabled_ = true;
+    std::vector<request_detail::SerializedResponse> stop_responses_;
+    std::vector<request_detail::SerializedResponse> bus_responses_;
+    // ответ на запрос Stop или Bus о неизвестной остановке или маршруте
+    request_detail::SerializedResponse not_found_response_;
+    // пул создается при первой обработке запросов, если потоков больше одного
+    std::unique_ptr<parallel::ThreadPool> thread_pool_;
 
     // Читает JSON из потока
     json::Document ReadJson(std::istream& input) const;
 
-    void AddStopsToCatalogue(transport::TransportCatalogue& catalogue) const;
-    void AddBusesToCatalogue(transport::TransportCatalogue& catalogue) const;
+    // Разбирает документ с базой из буфера, передавая события handler (см. LoadJsonToCatalogue)
+    void ParseBaseDocument(std::string_view input, StreamingHandler& handler);
+
+    // Раздел документа с базой по ключу или nullptr, если его нет. Отложенный раздел разбирается
+    // при первом обращении, ошибка в его записи выбрасывается исключением ParsingError
+    const json::Node* FindSection(std::string_view key) const;
 
-    // Добавляет запрос типа base_request в базу к stop_requests или bus_requests 
-    void AddRequestToCommands(const json::Dict& request_map);
-    // Добавляет запрос типа stat_request в список запросов к базе данных requests_
-    void AddRequestToRequests(const json::Dict& request_map);
+    // Пул потоков для параллельной работы (вместе с вызывающим - threads_count_ потоков), создается при первом обращении
+    parallel::ThreadPool& GetThreadPool();
 
-    // Формирует списки команд на заполнение базы данных и запросов к ней 
-    void FormAllRequestsData(const json::Document& document);
     
     // Обрабатывает один запрос и возвращает словарь данных ответа на запрос
     json::Dict ProcessOneRequest(RequestHandler& request_handler, const request_detail::RequestDescription& request) const;
@@ -229,6 +240,31 @@ private:
 
     // Обрабатывает один запрос типа Route и возвращает словарь данных ответа на запрос "items", "request_id", "total_time"
     json::Dict ProcessRouteRequest(const request_detail::RequestDescription& request) const;
+    // Формирует ответ на запрос типа Route по уже найденному маршруту
+    json::Dict ProcessRouteRequest(const request_detail::RequestDescription& request, const routing::TransportRouteInfo& route_info) const;
+
+    // Готовит всё, что нужно для ответов на запросы stat_requests_: маршрутизатор, индекс названий, параметры карты, пул потоков
+    void PrepareForBatchRequests(RequestHandler& request_handler);
+
+    // Обрабатывает запросы stat_requests_ порциями по window_size (в пуле потоков, если он есть)
+    // и передает запросы с ответами on_response в порядке запросов. Запросы, для которых
+    // есть записанный ответ (FindCachedResponse), не обрабатываются: их ответ передается пустым
+    void ProcessBatchRequests(RequestHandler& request_handler, size_t window_size,
+                              const std::function<void(const request_detail::RequestDescription&, json::Dict)>& on_response);
+
+    // Находит одинаковые запросы stat_requests_ (заполняет first_same_requests_ и batch_stats_)
+    void DeduplicateRequests();
+
+    // Записывает ответы для всех остановок и маршрутов, о которых есть запросы Stop и Bus в stat_requests_
+    void PrepareResponseCache(const RequestHandler& request_handler);
+    // Записанный ответ на запрос или nullptr, если его нет
+    const request_detail::SerializedResponse* FindCachedResponse(const request_detail::RequestDescription& request) const;
+
+    // Находит маршруты для всех запросов типа Route одной группой, ответы - в порядке запросов
+    std::vector<routing::TransportRouteInfo> FindRoutesForRouteRequests(const RequestHandler& request_handler);
+
+    // Обрабатывает один запрос типа Suggest и возвращает словарь данных ответа на запрос "buses", "request_id", "stops"
+    json::Dict ProcessSuggestRequest(const request_detail::RequestDescription& request) const;
 
     // Сортируем так, чтобы все запросы пути шли в конце
     void SortRequests() {
@@ -239,6 +275,8 @@ private:
 
     void BuildRouterForRouteRequests(RequestHandler& request_handler);
 
+    void BuildNameIndexForSuggestRequests(const RequestHandler& request_handler);
+
 
 
 
@@ -0,0 +1,311 @@
+#include "json_scanner.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define JSON_SCAN_X86
+#include <immintrin.h>
+#endif
+
+namespace json_scan {
+
+namespace {
+using namespace std::literals;
+
+constexpr size_t BLOCK_SIZE = 64;
+
+// Маски символов одного блока: бит i соответствует i-му байту блока
+struct BlockMasks {
+    uint64_t quote = 0;
+    uint64_t backslash = 0;
+    uint64_t space = 0;         // ' ', \t, \n, \v, \f, \r - те же, что пропускает парсер
+    uint64_t op = 0;            // { } [ ] : ,
+    uint64_t line_break = 0;    // \n, \r
+};
+
+BlockMasks ClassifyScalar(const char* block) {
+    BlockMasks masks;
+    for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+        const uint64_t bit = uint64_t{1} << i;
+        switch (block[i]) {
+            case '"':
+                masks.quote |= bit;
+                break;
+            case '\\':
+                masks.backslash |= bit;
+                break;
+            case '\n':
+            case '\r':
+                masks.line_break |= bit;
+                masks.space |= bit;
+                break;
+            case ' ':
+            case '\t':
+            case '\v':
+            case '\f':
+                masks.space |= bit;
+                break;
+            case '{':
+            case '}':
+            case '[':
+            case ']':
+            case ':':
+            case ',':
+                masks.op |= bit;
+                break;
+            default:
+                break;
+        }
+    }
+    return masks;
+}
+
+#ifdef JSON_SCAN_X86
+
+/*
+Векторные версии сравнивают сразу 16 или 32 байта.
+Пробелы \t..\r ищутся одной проверкой диапазона: min(c - 9, 4) == c - 9 (без знака),
+скобки - сравнением c | 0x20 с { и }, так как [ и ] отличаются от них только этим битом
+*/
+
+__attribute__((target("sse2"))) inline
+BlockMasks ClassifySse2(const char* block) {
+    BlockMasks masks;
+    for (int part = 0; part < 4; ++part) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * part));
+        const __m128i tab_to_cr = _mm_sub_epi8(chunk, _mm_set1_epi8('\t'));
+        const __m128i lower = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+
+        const __m128i quote = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'));
+        const __m128i backslash = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'));
+        const __m128i line_break = _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')),
+                                                _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')));
+        const __m128i space = _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+                                           _mm_cmpeq_epi8(_mm_min_epu8(tab_to_cr, _mm_set1_epi8(4)), tab_to_cr));
+        const __m128i op = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(lower, _mm_set1_epi8('{')),
+                                                     _mm_cmpeq_epi8(lower, _mm_set1_epi8('}'))),
+                                        _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(':')),
+                                                     _mm_cmpeq_epi8(chunk, _mm_set1_epi8(','))));
+
+        const int shift = 16 * part;
+        masks.quote |= uint64_t{static_cast<uint16_t>(_mm_movemask_epi8(quote))} << shift;
+        masks.backslash |= uint64_t{static_cast<uint16_t>(_mm_movemask_epi8(backslash))} << shift;
+        masks.line_break |= uint64_t{static_cast<uint16_t>(_mm_movemask_epi8(line_break))} << shift;
+        masks.space |= uint64_t{static_cast<uint16_t>(_mm_movemask_epi8(space))} << shift;
+        masks.op |= uint64_t{static_cast<uint16_t>(_mm_movemask_epi8(op))} << shift;
+    }
+    return masks;
+}
+
+__attribute__((target("avx2"))) inline
+BlockMasks ClassifyAvx2(const char* block) {
+    BlockMasks masks;
+    for (int part = 0; part < 2; ++part) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32 * part));
+        const __m256i tab_to_cr = _mm256_sub_epi8(chunk, _mm256_set1_epi8('\t'));
+        const __m256i lower = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+
+        const __m256i quote = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"'));
+        const __m256i backslash = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\'));
+        const __m256i line_break = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n')),
+                                                   _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r')));
+        const __m256i space = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')),
+                                              _mm256_cmpeq_epi8(_mm256_min_epu8(tab_to_cr, _mm256_set1_epi8(4)), tab_to_cr));
+        const __m256i op = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(lower, _mm256_set1_epi8('{')),
+                                                           _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('}'))),
+                                           _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(':')),
+                                                           _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(','))));
+
+        const int shift = 32 * part;
+        masks.quote |= uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(quote))} << shift;
+        masks.backslash |= uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(backslash))} << shift;
+        masks.line_break |= uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(line_break))} << shift;
+        masks.space |= uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(space))} << shift;
+        masks.op |= uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(op))} << shift;
+    }
+    return masks;
+}
+
+#endif  // JSON_SCAN_X86
+
+// Бит i результата - xor битов 0..i аргумента
+inline uint64_t PrefixXor(uint64_t bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+/*
+Возвращает маску экранированных символов: символ после нечетного числа обратных слэшей подряд.
+Серии слэшей, начинающиеся на четном и нечетном бите, разделяются сложением:
+перенос проходит серию до конца и меняет четность ее последнего бита
+*/
+inline uint64_t FindEscaped(uint64_t backslash, ScanState& state) {
+    constexpr uint64_t EVEN_BITS = 0x5555555555555555ULL;
+    backslash &= ~state.prev_escaped;
+    const uint64_t follows_escape = (backslash << 1) | state.prev_escaped;
+    const uint64_t odd_sequence_starts = backslash & ~EVEN_BITS & ~follows_escape;
+    const uint64_t sequences_starting_on_even_bits = odd_sequence_starts + backslash;
+    // перенос из старшего бита: серия продолжается в следующем блоке
+    state.prev_escaped = sequences_starting_on_even_bits < odd_sequence_starts ? 1 : 0;
+    const uint64_t invert_mask = sequences_starting_on_even_bits << 1;
+    return (EVEN_BITS ^ invert_mask) & follows_escape;
+}
+
+// Возвращает маску структурных позиций блока
+inline uint64_t ScanBlock(const BlockMasks& masks, ScanState& state) {
+    const uint64_t quote = masks.quote & ~FindEscaped(masks.backslash, state);
+    // строка - от открывающей кавычки включительно до закрывающей не включительно
+    const uint64_t in_string = PrefixXor(quote) ^ state.prev_in_string;
+    state.prev_in_string = (in_string >> 63) ? ~uint64_t{0} : 0;
+
+    // число или литерал начинается после пробела, скобки, запятой, двоеточия или кавычки
+    const uint64_t separator = masks.space | masks.op | quote;
+    const uint64_t after_separator = (separator << 1) | state.prev_separator;
+    state.prev_separator = separator >> 63;
+    const uint64_t outside = ~in_string & ~quote;
+    const uint64_t scalar_start = outside & ~masks.space & ~masks.op & after_separator;
+
+    return (masks.op & outside) | quote | ((masks.backslash | masks.line_break) & in_string) | scalar_start;
+}
+
+// Записывает позиции единичных битов bits, смещенные на offset, в out и возвращает их число.
+// После out должно быть место хотя бы для 8 позиций
+inline size_t WriteIndices(uint64_t bits, uint32_t offset, uint32_t* out) {
+    const size_t bits_count = static_cast<size_t>(__builtin_popcountll(bits));
+    // первые 8 позиций пишутся без проверок, лишние записи затрутся следующим блоком;
+    // старший бит не дает вызвать ctz от нуля и не меняет ответ для ненулевой маски
+    constexpr uint64_t HIGH_BIT = uint64_t{1} << 63;
+    for (int i = 0; i < 8; ++i) {
+        out[i] = offset + static_cast<uint32_t>(__builtin_ctzll(bits | HIGH_BIT));
+        bits &= bits - 1;
+    }
+    for (size_t i = 8; i < bits_count; ++i) {
+        out[i] = offset + static_cast<uint32_t>(__builtin_ctzll(bits));
+        bits &= bits - 1;
+    }
+    return bits_count;
+}
+
+// Обрабатывает блоки input из [begin, end) и возвращает число записанных в out позиций.
+// Встраивается в функции для каждого набора инструкций, чтобы Classify тоже встроилась
+template <BlockMasks (*Classify)(const char*)>
+inline __attribute__((always_inline))
+size_t ScanBlocks(std::string_view input, size_t begin, size_t end, ScanState& state, uint32_t* out) {
+    size_t count = 0;
+    size_t offset = begin;
+    for (; offset + BLOCK_SIZE <= end; offset += BLOCK_SIZE) {
+        const uint64_t bits = ScanBlock(Classify(input.data() + offset), state);
+        count += WriteIndices(bits, static_cast<uint32_t>(offset), out + count);
+    }
+    if (offset < end) {
+        // последний неполный блок дополняется пробелами
+        char last_block[BLOCK_SIZE];
+        std::memset(last_block, ' ', BLOCK_SIZE);
+        std::memcpy(last_block, input.data() + offset, end - offset);
+        const uint64_t bits = ScanBlock(ClassifyScalar(last_block), state);
+        count += WriteIndices(bits, static_cast<uint32_t>(offset), out + count);
+    }
+    return count;
+}
+
+size_t ScanScalar(std::string_view input, size_t begin, size_t end, ScanState& state, uint32_t* out) {
+    return ScanBlocks<ClassifyScalar>(input, begin, end, state, out);
+}
+
+#ifdef JSON_SCAN_X86
+
+__attribute__((target("sse2")))
+size_t ScanSse2(std::string_view input, size_t begin, size_t end, ScanState& state, uint32_t* out) {
+    return ScanBlocks<ClassifySse2>(input, begin, end, state, out);
+}
+
+__attribute__((target("avx2")))
+size_t ScanAvx2(std::string_view input, size_t begin, size_t end, ScanState& state, uint32_t* out) {
+    return ScanBlocks<ClassifyAvx2>(input, begin, end, state, out);
+}
+
+#endif  // JSON_SCAN_X86
+
+bool IsSupported(Level level) {
+    switch (level) {
+        case Level::SCALAR:
+            return true;
+#ifdef JSON_SCAN_X86
+        case Level::SSE2:
+            return __builtin_cpu_supports("sse2");
+        case Level::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+}  // namespace
+
+Level GetBestLevel() {
+    static const Level best_level = IsSupported(Level::AVX2) ? Level::AVX2
+                                    : IsSupported(Level::SSE2) ? Level::SSE2
+                                    : Level::SCALAR;
+    return best_level;
+}
+
+const char* GetLevelName(Level level) {
+    switch (level) {
+        case Level::SCALAR:
+            return "scalar";
+        case Level::SSE2:
+            return "sse2";
+        case Level::AVX2:
+            return "avx2";
+    }
+    return "unknown";
+}
+
+StructuralScanner::StructuralScanner(std::string_view input, Level level)
+    : input_(input) {
+    if (input.size() >= std::numeric_limits<uint32_t>::max()) {
+        throw std::invalid_argument("JSON input is too large for structural index"s);
+    }
+    if (!IsSupported(level)) {
+        throw std::invalid_argument("Scanner level "s + GetLevelName(level) + " is not supported"s);
+    }
+    switch (level) {
+#ifdef JSON_SCAN_X86
+        case Level::AVX2:
+            scan_ = ScanAvx2;
+            break;
+        case Level::SSE2:
+            scan_ = ScanSse2;
+            break;
+#endif
+        default:
+            scan_ = ScanScalar;
+            break;
+    }
+    // позиций в порции не больше ее размера, еще BLOCK_SIZE - запас для записи без проверок
+    const size_t blocks_size = (std::min(input.size(), CHUNK_SIZE) + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+    indices_.reset(new uint32_t[blocks_size + BLOCK_SIZE]);
+}
+
+bool StructuralScanner::ScanNextChunk() {
+    if (offset_ == input_.size()) {
+        count_ = 0;
+        return false;
+    }
+    const size_t chunk_end = std::min(input_.size(), offset_ + CHUNK_SIZE);
+    count_ = scan_(input_, offset_, chunk_end, state_, indices_.get());
+    offset_ = chunk_end;
+    return true;
+}
+
+}  // namespace json_scan
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+/*
+ * Предварительный проход по JSON (stage 1): поиск структурных позиций в буфере блоками по 64 байта.
+ *
+ * Для каждого блока векторными инструкциями строятся битовые маски кавычек, обратных слэшей,
+ * пробельных и структурных символов. Затем по маскам без ветвлений определяются экранированные
+ * символы и границы строк (префиксный xor по кавычкам), и в результат попадают позиции:
+ *  - символов { } [ ] : , вне строк;
+ *  - открывающих и закрывающих кавычек;
+ *  - обратных слэшей и переводов строк внутри строк;
+ *  - начал чисел и литералов (первый непробельный символ после разделителя).
+ *
+ * Буфер обрабатывается порциями по 64 КБ, чтобы позиции порции оставались в кеше, пока их
+ * читает парсер: json::Load по ним перепрыгивает пробелы и содержимое строк без экранирования.
+ * Реализация выбирается при запуске по возможностям процессора: AVX2, SSE2 или скалярная.
+ */
+
+namespace json_scan {
+
+enum class Level {
+    SCALAR,
+    SSE2,
+    AVX2,
+};
+
+// Лучшая реализация, доступная на этом процессоре
+Level GetBestLevel();
+
+const char* GetLevelName(Level level);
+
+// Состояние, переносимое через границу блоков
+struct ScanState {
+    uint64_t prev_escaped = 0;      // первый символ следующего блока экранирован
+    uint64_t prev_in_string = 0;    // следующий блок начинается внутри строки (все единицы)
+    uint64_t prev_separator = 1;    // начало буфера считается разделителем
+};
+
+// Ищет структурные позиции в буфере порциями. Буфер должен жить дольше сканера
+class StructuralScanner {
+public:
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    // Размер input должен быть меньше 4 ГБ, а level - доступен на процессоре,
+    // иначе выбрасывается исключение invalid_argument
+    explicit StructuralScanner(std::string_view input, Level level = GetBestLevel());
+
+    /*
+    Находит позиции в следующей порции буфера (смещения от начала input по возрастанию),
+    они доступны через begin() и end() до следующего вызова.
+    Возвращает false, если буфер закончился. Порция может не содержать ни одной позиции
+    */
+    bool ScanNextChunk();
+
+    const uint32_t* begin() const {
+        return indices_.get();
+    }
+    const uint32_t* end() const {
+        return indices_.get() + count_;
+    }
+
+private:
+    using ScanFunc = size_t (*)(std::string_view input, size_t begin, size_t end, ScanState& state, uint32_t* out);
+
+    std::string_view input_;
+    ScanFunc scan_;
+    ScanState state_;
+    size_t offset_ = 0;
+    std::unique_ptr<uint32_t[]> indices_;
+    size_t count_ = 0;
+};
+
+}  // namespace json_scan
@@ -0,0 +1,313 @@
+#include "json_writer.h"
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std::literals;
+
+namespace json {
+
+namespace {
+
+constexpr uint64_t BYTES_ONES = 0x0101010101010101ull;
+constexpr uint64_t BYTES_HIGH_BITS = 0x8080808080808080ull;
+
+// Старшие биты байтов word, равных c (как в memchr: младший отмеченный байт - первое совпадение)
+inline uint64_t MatchBytes(uint64_t word, char c) {
+    const uint64_t diff = word ^ (BYTES_ONES * static_cast<unsigned char>(c));
+    return (diff - BYTES_ONES) & ~diff & BYTES_HIGH_BITS;
+}
+
+inline bool NeedsEscape(char c) {
+    return c == '"' || c == '\\' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// Находит первый символ строки, который выводится с экранированием, проверяя по 8 байт за раз
+const char* FindEscaped(const char* begin, const char* end) {
+    const char* pos = begin;
+    for (; end - pos >= 8; pos += 8) {
+        uint64_t word;
+        std::memcpy(&word, pos, sizeof(word));
+        if ((MatchBytes(word, '"') | MatchBytes(word, '\\') | MatchBytes(word, '\n')
+             | MatchBytes(word, '\r') | MatchBytes(word, '\t')) != 0) {
+            break;
+        }
+    }
+    while (pos != end && !NeedsEscape(*pos)) {
+        ++pos;
+    }
+    return pos;
+}
+
+}  // namespace
+
+Writer::Writer(std::ostream& output, bool compact)
+    : output_(output)
+    , compact_(compact) {
+    buffer_.reserve(BUFFER_SIZE);
+}
+
+Writer::~Writer() {
+    Flush();
+}
+
+void Writer::Flush() {
+    output_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear();
+}
+
+void Writer::WriteNewLine(size_t depth) {
+    if (!compact_) {
+        buffer_.push_back('\n');
+        buffer_.append(depth * INDENT_STEP, ' ');
+    }
+}
+
+void Writer::BeginValue() {
+    if (frames_.empty()) {
+        if (root_written_) {
+            throw std::logic_error("LOG err: In Writer - the root value has been already written"s);
+        }
+        root_written_ = true;
+        return;
+    }
+    Frame& frame = frames_.back();
+    if (frame.is_dict) {
+        if (!frame.has_key) {
+            throw std::logic_error("LOG err: In Writer - a value in a Dict must follow a Key"s);
+        }
+        frame.has_key = false;
+        return;
+    }
+    if (!frame.empty) {
+        buffer_.push_back(',');
+    }
+    frame.empty = false;
+    WriteNewLine(frames_.size());
+}
+
+void Writer::EndValue() {
+    if (buffer_.size() >= BUFFER_SIZE) {
+        Flush();
+    }
+}
+
+void Writer::WriteString(std::string_view value) {
+    buffer_.push_back('"');
+    const char* end = value.data() + value.size();
+    // участки без экранируемых символов копируются целиком
+    for (const char* run = value.data(); run != end;) {
+        const char* special = FindEscaped(run, end);
+        buffer_.append(run, special);
+        if (special == end) {
+            break;
+        }
+        switch (*special) {
+            case '\r':
+                buffer_.append("\\r"sv);
+                break;
+            case '\n':
+                buffer_.append("\\n"sv);
+                break;
+            case '\t':
+                buffer_.append("\\t"sv);
+                break;
+            default:
+                // Символы " и \ выводятся как \" или \\, соответственно
+                buffer_.push_back('\\');
+                buffer_.push_back(*special);
+                break;
+        }
+        run = special + 1;
+    }
+    buffer_.push_back('"');
+}
+
+template <typename Func>
+Writer::BaseContext Writer::WriteScalar(Func write) {
+    BeginValue();
+    write();
+    EndValue();
+    return BaseContext(*this);
+}
+
+Writer::BaseContext Writer::Value(std::nullptr_t) {
+    return WriteScalar([this]() {
+        buffer_.append("null"sv);
+    });
+}
+
+Writer::BaseContext Writer::Value(bool value) {
+    return WriteScalar([this, value]() {
+        buffer_.append(value ? "true"sv : "false"sv);
+    });
+}
+
+Writer::BaseContext Writer::Value(int value) {
+    return WriteScalar([this, value]() {
+        char chars[16];
+        const auto result = std::to_chars(chars, chars + sizeof(chars), value);
+        buffer_.append(chars, result.ptr);
+    });
+}
+
+Writer::BaseContext Writer::Value(double value) {
+    return WriteScalar([this, value]() {
+        // тот же формат, что у вывода double в std::ostream по умолчанию (%g, 6 значащих цифр)
+        char chars[32];
+        const auto result = std::to_chars(chars, chars + sizeof(chars), value, std::chars_format::general, 6);
+        buffer_.append(chars, result.ptr);
+    });
+}
+
+Writer::BaseContext Writer::Value(std::string_view value) {
+    return WriteScalar([this, value]() {
+        WriteString(value);
+    });
+}
+
+Writer::BaseContext Writer::Value(const std::string& value) {
+    return Value(std::string_view(value));
+}
+
+Writer::BaseContext Writer::Value(const char* value) {
+    return Value(std::string_view(value));
+}
+
+Writer::BaseContext Writer::Value(const Node& value) {
+    WriteNode(value);
+    return BaseContext(*this);
+}
+
+Writer::BaseContext Writer::Value(const Array& value) {
+    StartArray();
+    for (const Node& node : value) {
+        WriteNode(node);
+    }
+    return EndArray();
+}
+
+Writer::BaseContext Writer::Value(const Dict& value) {
+    StartDict();
+    for (const auto& [key, node] : value) {
+        Key(key);
+        WriteNode(node);
+    }
+    return EndDict();
+}
+
+Writer::BaseContext Writer::RawValue(std::initializer_list<std::string_view> parts) {
+    return WriteScalar([this, parts]() {
+        for (std::string_view part : parts) {
+            buffer_.append(part);
+        }
+    });
+}
+
+void Writer::WriteNode(const Node& value) {
+    std::visit(
+        [this](const auto& node_value) {
+            Value(node_value);
+        },
+        value.GetValue());
+}
+
+Writer::DictItemContext Writer::StartDict() {
+    BeginValue();
+    buffer_.push_back('{');
+    frames_.push_back({true, true, false});
+    return DictItemContext(*this);
+}
+
+Writer::DictValueContext Writer::Key(std::string_view key) {
+    if (frames_.empty() || !frames_.back().is_dict) {
+        throw std::logic_error("LOG err: In Key - Opened value is not a Dict"s);
+    }
+    Frame& frame = frames_.back();
+    if (frame.has_key) {
+        throw std::logic_error("LOG err: In Key - the previous Key has no value"s);
+    }
+    if (!frame.empty) {
+        buffer_.push_back(',');
+    }
+    frame.empty = false;
+    frame.has_key = true;
+    WriteNewLine(frames_.size());
+    WriteString(key);
+    buffer_.append(compact_ ? ":"sv : ": "sv);
+    return DictValueContext(*this);
+}
+
+Writer::ArrayItemContext Writer::StartArray() {
+    BeginValue();
+    buffer_.push_back('[');
+    frames_.push_back({false, true, false});
+    return ArrayItemContext(*this);
+}
+
+void Writer::WriteEnd(bool is_dict) {
+    if (frames_.empty() || frames_.back().is_dict != is_dict) {
+        throw std::logic_error(is_dict ? "LOG err: In EndDict - Last opened value is not a Dict"s
+                                       : "LOG err: In EndArray - Last opened value is not an Array"s);
+    }
+    if (frames_.back().has_key) {
+        throw std::logic_error("LOG err: In EndDict - the last Key has no value"s);
+    }
+    const bool empty = frames_.back().empty;
+    frames_.pop_back();
+    if (!compact_) {
+        // пустой контейнер в обычном режиме тоже выводится на нескольких строках
+        if (empty) {
+            buffer_.push_back('\n');
+        }
+        WriteNewLine(frames_.size());
+    }
+    buffer_.push_back(is_dict ? '}' : ']');
+    EndValue();
+}
+
+Writer::BaseContext Writer::EndDict() {
+    WriteEnd(true);
+    return BaseContext(*this);
+}
+
+Writer::BaseContext Writer::EndArray() {
+    WriteEnd(false);
+    return BaseContext(*this);
+}
+
+
+// Методы основного контекста передаются в Writer
+
+Writer::DictItemContext Writer::BaseContext::StartDict() {
+    return writer_.StartDict();
+}
+
+Writer::DictValueContext Writer::BaseContext::Key(std::string_view key) {
+    return writer_.Key(key);
+}
+
+Writer::ArrayItemContext Writer::BaseContext::StartArray() {
+    return writer_.StartArray();
+}
+
+Writer::BaseContext Writer::BaseContext::EndDict() {
+    return writer_.EndDict();
+}
+
+Writer::BaseContext Writer::BaseContext::EndArray() {
+    return writer_.EndArray();
+}
+
+
+void Print(const Document& doc, std::ostream& output) {
+    Writer(output).Value(doc.GetRoot());
+}
+
+void PrintCompact(const Document& doc, std::ostream& output) {
+    Writer(output, /*compact*/ true).Value(doc.GetRoot());
+}
+
+}  // namespace json
@@ -0,0 +1,181 @@
+#pragma once
+
+#include "json.h"
+
+#include <initializer_list>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json {
+
+/*
+Потоковая запись JSON без построения дерева: значения выводятся в буфер сразу по вызову методов,
+а буфер сбрасывается в поток крупными блоками. Результат совпадает с выводом Print
+(или PrintCompact в компактном режиме) для того же документа.
+
+Как и у Builder, последовательность вызовов проверяется при компиляции через цепочки
+контекстов, а ошибки, которые нельзя поймать при компиляции, - исключением logic_error
+*/
+class Writer {
+private:
+    // Классы для формирования ошибок компиляции
+    // при некорректной последовательности вызовов методов
+    class BaseContext;
+    class DictItemContext;
+    class DictValueContext;
+    class ArrayItemContext;
+
+public:
+    // compact - вывод в одну строку без пробелов и отступов
+    explicit Writer(std::ostream& output, bool compact = false);
+
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    // Сбрасывает в поток то, что осталось в буфере
+    ~Writer();
+
+    BaseContext Value(std::nullptr_t);
+    BaseContext Value(bool value);
+    BaseContext Value(int value);
+    BaseContext Value(double value);
+    BaseContext Value(std::string_view value);
+    BaseContext Value(const std::string& value);
+    BaseContext Value(const char* value);
+    BaseContext Value(const Node& value);
+    BaseContext Value(const Array& value);
+    BaseContext Value(const Dict& value);
+
+    /*
+    Выводит значение, уже записанное в JSON: части parts выводятся подряд без проверки.
+    При выводе с отступами текст должен быть записан с отступами того уровня, на котором выводится значение
+    */
+    BaseContext RawValue(std::initializer_list<std::string_view> parts);
+
+    DictItemContext StartDict();
+    DictValueContext Key(std::string_view key);
+    ArrayItemContext StartArray();
+    BaseContext EndDict();
+    BaseContext EndArray();
+
+    // Записан ли корневой элемент целиком
+    bool IsComplete() const {
+        return root_written_ && frames_.empty();
+    }
+
+    // Сбрасывает буфер в поток
+    void Flush();
+
+private:
+    // Размер буфера, после которого он сбрасывается в поток
+    static constexpr size_t BUFFER_SIZE = 64 * 1024;
+    static constexpr int INDENT_STEP = 4;
+
+    // Открытый массив или словарь
+    struct Frame {
+        bool is_dict = false;
+        bool empty = true;
+        // в словаре записан ключ, значение которого еще не записано
+        bool has_key = false;
+    };
+
+    std::ostream& output_;
+    const bool compact_;
+    std::string buffer_;
+    std::vector<Frame> frames_;
+    bool root_written_ = false;
+
+    // Проверяет, что значение можно записать, и выводит разделитель перед ним
+    void BeginValue();
+    // Отмечает конец значения и сбрасывает буфер, если он заполнился
+    void EndValue();
+
+    void WriteNewLine(size_t depth);
+    void WriteString(std::string_view value);
+    void WriteNode(const Node& value);
+    void WriteEnd(bool is_dict);
+
+    template <typename Func>
+    BaseContext WriteScalar(Func write);
+};
+
+
+// Основной контекст - со всеми методами Writer
+class Writer::BaseContext {
+public:
+    explicit BaseContext(Writer& writer)
+        : writer_(writer) {
+    }
+
+    template <typename ValueType>
+    BaseContext Value(ValueType&& value) {
+        return writer_.Value(std::forward<ValueType>(value));
+    }
+
+    DictItemContext StartDict();
+    DictValueContext Key(std::string_view key);
+    ArrayItemContext StartArray();
+    BaseContext EndDict();
+    BaseContext EndArray();
+
+    Writer& GetWriter() {
+        return writer_;
+    }
+
+private:
+    Writer& writer_;
+};
+
+
+// После Key - только Value, StartDict или StartArray
+class Writer::DictValueContext final : public BaseContext {
+public:
+    using BaseContext::BaseContext;
+
+    template <typename ValueType>
+    DictItemContext Value(ValueType&& value);
+
+    DictValueContext Key(std::string_view key) = delete;
+    BaseContext EndDict() = delete;
+    BaseContext EndArray() = delete;
+};
+
+
+// После StartDict или значения по ключу - только Key или EndDict
+class Writer::DictItemContext final : public BaseContext {
+public:
+    using BaseContext::BaseContext;
+
+    template <typename ValueType>
+    BaseContext Value(ValueType&& value) = delete;
+    DictItemContext StartDict() = delete;
+    ArrayItemContext StartArray() = delete;
+    BaseContext EndArray() = delete;
+};
+
+
+// После StartArray или элемента массива - Value, StartDict, StartArray или EndArray
+class Writer::ArrayItemContext final : public BaseContext {
+public:
+    using BaseContext::BaseContext;
+
+    template <typename ValueType>
+    ArrayItemContext Value(ValueType&& value) {
+        GetWriter().Value(std::forward<ValueType>(value));
+        return ArrayItemContext(GetWriter());
+    }
+
+    DictValueContext Key(std::string_view key) = delete;
+    BaseContext EndDict() = delete;
+};
+
+
+template <typename ValueType>
+Writer::DictItemContext Writer::DictValueContext::Value(ValueType&& value) {
+    GetWriter().Value(std::forward<ValueType>(value));
+    return DictItemContext(GetWriter());
+}
+
+}  // namespace json
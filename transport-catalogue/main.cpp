@@ -1,10 +1,68 @@
+#include "binary_protocol.h"
 #include "json_reader.h"
 #include "map_renderer.h"
+#include "server.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
 
+using namespace std::literals;
 
-int main() {
+
+// Во сколько раз число потоков может превышать число ядер
+constexpr long long MAX_THREADS_PER_CORE = 8;
+
+// Возвращает число потоков из параметра --threads N (по умолчанию - по числу ядер).
+// Значение должно быть целым числом от 1 до MAX_THREADS_PER_CORE * число ядер, иначе используется значение по умолчанию
+static size_t ParseThreadsCount(int argc, char** argv) {
+    const unsigned cores_count = std::max(1u, std::thread::hardware_concurrency());
+    const long long max_threads_count = MAX_THREADS_PER_CORE * cores_count;
+    size_t threads_count = cores_count;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], "--threads") == 0) {
+            const std::string value = argv[i + 1];
+            long long parsed_count = 0;
+            size_t parsed_size = 0;
+            try {
+                parsed_count = std::stoll(value, &parsed_size);
+            } catch (const std::exception&) {
+                parsed_size = 0;
+            }
+            if (parsed_size != value.size() || parsed_count < 1 || parsed_count > max_threads_count) {
+                std::cerr << "LOG err: wrong value of --threads (expected 1.."s << max_threads_count << "), "s 
+                          << threads_count << " threads will be used"s << std::endl;
+                continue;
+            }
+            threads_count = static_cast<size_t>(parsed_count);
+        }
+    }
+    return threads_count;
+}
+
+// Возвращает значение параметра name (следующий за ним аргумент), если он задан
+static std::optional<std::string> FindOptionValue(int argc, char** argv, const char* name) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], name) == 0) {
+            return std::string(argv[i + 1]);
+        }
+    }
+    return std::nullopt;
+}
+
+// Проверяет, задан ли флаг name
+static bool HasFlag(int argc, char** argv, const char* name) {
+    return std::any_of(argv + 1, argv + argc, [name](const char* arg) {
+        return std::strcmp(arg, name) == 0;
+    });
+}
+
+
+int main(int argc, char** argv) {
     /*
      * Примерная структура программы:
      *
@@ -14,21 +72,117 @@ int main() {
      * с ответами Вывести в stdout ответы в виде JSON
      */
 
+    /*
+     * Режим сервера (--serve): база загружается один раз из файла --base FILE 
+     * (или из первого значения JSON в потоке ввода), после чего запросы stat_requests 
+     * принимаются по одному в строке из потока ввода, либо от многих клиентов сразу 
+     * через Unix-сокет --socket PATH или TCP-порт --port N на 127.0.0.1
+     * (по сети с флагом --binary - в двоичном протоколе)
+     */
+    const bool serve_mode = HasFlag(argc, argv, "--serve");
+    const std::optional<std::string> base_path = FindOptionValue(argc, argv, "--base");
+    const std::optional<std::string> socket_path = FindOptionValue(argc, argv, "--socket");
+    const std::optional<std::string> port = FindOptionValue(argc, argv, "--port");
+    const size_t threads_count = ParseThreadsCount(argc, argv);
+
     JsonReader json_reader;
-    // 0. Считываем json из потока ввода 
-    json_reader.LoadJson(std::cin);
-    // 1. Создаем справочник
+    json_reader.SetThreadsCount(threads_count);
+    // --no-response-cache: ответы на запросы Stop и Bus строятся заново для каждого запроса
+    json_reader.SetResponseCacheEnabled(!HasFlag(argc, argv, "--no-response-cache"));
+    // --router-mode single-source: пути для запросов Route ищутся из каждой остановки отправления
+    // без таблицы путей между всеми парами остановок (all-pairs, по умолчанию)
+    if (const std::optional<std::string> router_mode = FindOptionValue(argc, argv, "--router-mode")) {
+        if (*router_mode == "single-source"s) {
+            json_reader.SetRouterMode(graph::RouterMode::SINGLE_SOURCE);
+        }
+        else if (*router_mode != "all-pairs"s) {
+            std::cerr << "LOG err: wrong value of --router-mode, all-pairs will be used"s << std::endl;
+        }
+    }
+    // 0. Создаем справочник
     transport::TransportCatalogue catalogue;
-    // 2. Создаем пустой отрисовщик
+    // 1. Создаем пустой отрисовщик
     renderer::MapRenderer renderer;
-    // 3. Создаем перенаправитель запросов к базе 
+    // 2. Создаем перенаправитель запросов к базе 
     RequestHandler request_handler(catalogue, renderer);
-    // 4. Заполняем справочник
-    json_reader.ApplyCommands(catalogue);
+    // Изменения каталога передаются карте и маршрутизатору
+    catalogue.Subscribe([&request_handler](const transport::CatalogueChange& change) {
+        request_handler.OnCatalogueChanged(change);
+    });
+    // 3. Считываем json из потока ввода, сразу заполняя справочник
+    if (serve_mode && base_path) {
+        try {
+            json_reader.LoadJsonFileToCatalogue(*base_path, catalogue);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "LOG err: can not load base file "s << *base_path << ": "s << e.what() << std::endl;
+            return 1;
+        }
+    }
+    else if (serve_mode) {
+        // поток ввода читается не до конца: после базы (первого значения JSON) в нем идут запросы
+        try {
+            std::istringstream base_stream(json::ReadValue(std::cin));
+            json_reader.LoadJsonToCatalogue(base_stream, catalogue);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "LOG err: can not load base from input: "s << e.what() << std::endl;
+            return 1;
+        }
+    }
+    else {
+        json_reader.LoadJsonToCatalogue(std::cin, catalogue);
+    }
+
+    if (serve_mode) {
+        json_reader.PrepareForSingleRequests(request_handler);
+        // --binary: двоичный протокол вместо NDJSON (только по сети)
+        const bool binary_mode = HasFlag(argc, argv, "--binary");
+        server::MessageHandler handler = [&json_reader, &request_handler](const std::string& line) {
+            return json_reader.ProcessRequestLine(request_handler, line);
+        };
+        if (binary_mode) {
+            handler = [&request_handler](const std::string& payload) {
+                return binary::ProcessRequest(request_handler, payload);
+            };
+        }
+        try {
+            if (socket_path || port) {
+                server::ListenAddress address;
+                if (socket_path) {
+                    address.socket_path = *socket_path;
+                }
+                else {
+                    address.tcp_port = static_cast<uint16_t>(std::stoul(*port));
+                }
+                // запросы обрабатываются в пуле потоков, поток ввода-вывода только принимает и отправляет данные
+                server::ServeConnections(address, binary_mode ? server::Framing::LENGTH_PREFIXED : server::Framing::LINES, 
+                                         handler, threads_count);
+            }
+            else if (binary_mode) {
+                std::cerr << "LOG err: binary protocol requires --socket PATH or --port N"s << std::endl;
+                return 1;
+            }
+            else {
+                server::ServeStream(std::cin, std::cout, handler);
+            }
+        }
+        catch (const std::exception& e) {
+            std::cerr << "LOG err: server stopped: "s << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
     
-    // 5. Обрабатываем запросы и выводим результат
-    json_reader.ProcessRequestsAndGetResponse(request_handler);
-    json_reader.PrintResponse(std::cout); 
+    // 4. Обрабатываем запросы и выводим результат
+    json_reader.ProcessRequestsAndPrintResponse(request_handler, std::cout);
+    // --stats: статистика запросов в поток ошибок
+    if (HasFlag(argc, argv, "--stats")) {
+        const JsonReader::BatchStats& stats = json_reader.GetBatchStats();
+        std::cerr << "stat_requests: "s << stats.requests_count 
+                  << ", distinct: "s << stats.distinct_requests_count 
+                  << ", dedup ratio: "s << stats.GetDedupRatio() << std::endl;
+    }
     
     
     /* 
@@ -7,21 +7,43 @@
 #include <cstdlib>
 #include <iostream>
 #include <optional>
+#include <sstream>
 #include <unordered_map>
 #include <vector>
 
 using namespace renderer;
 
 
-// Формирует svg из набора элементов/рисунков/объектов типа Object
+// Выводит svg-документ из отрисованных слоев в порядке: линии маршрутов, названия маршрутов, 
+// кружки остановок, названия остановок
 void MapRenderer::Render(std::ostream& output) const {
-    map_document_.Render(output);
+    svg::Document::RenderBegin(output);
+    for (domain::BusId bus_id : drawn_buses_) {
+        output << bus_layers_.at(bus_id).route_line;
+    }
+    for (domain::BusId bus_id : drawn_buses_) {
+        output << bus_layers_.at(bus_id).labels;
+    }
+    for (domain::StopId stop_id : drawn_stops_) {
+        output << stop_layers_.at(stop_id).circle;
+    }
+    for (domain::StopId stop_id : drawn_stops_) {
+        output << stop_layers_.at(stop_id).label;
+    }
+    svg::Document::RenderEnd(output);
+}
+
+// Выводит объект так же, как его вывел бы svg::Document
+static void RenderToStream(const svg::Object& object, std::ostream& output) {
+    object.Render(svg::Document::MakeObjectsContext(output));
 }
 
-svg::Polyline MapRenderer::MakeRouteLine(const std::vector<const domain::Stop*>& stops, const detail::SphereProjector& projector, svg::Color line_color, double line_width) const {
+svg::Polyline MapRenderer::MakeRouteLine(const domain::Bus& bus, const detail::SphereProjector& projector, const StopGetter& get_stop, svg::Color line_color, double line_width) const {
     svg::Polyline route_line;
-    // Идем по остановкам и добавляем координаты в полилинию
-    for (const auto& stop_ptr : stops) {
+    // Идем по остановкам (включая обратный ход) и добавляем координаты в полилинию
+    const size_t stops_count = domain::GetRouteStopsCount(bus);
+    for (size_t i = 0; i < stops_count; ++i) {
+        const domain::Stop* stop_ptr = get_stop(domain::GetRouteStopId(bus, i));
         // Проецируем точку = формируем точку с координатами x, y
         svg::Point stop_point_on_map = projector(stop_ptr->coordinates);
         // Записываем точку в полилинию
@@ -37,30 +59,6 @@ svg::Polyline MapRenderer::MakeRouteLine(const std::vector<const domain::Stop*>&
 }
 
 
-// Формирует линии маршрутов в соответствии с заданным правилом преобразования координат и добавляет их в документ
-void MapRenderer::DrawRoutes(const std::vector<std::pair<std::string_view, const domain::Bus*>>& all_buses_data, const detail::SphereProjector& coord_projector) {
-    auto color_it = render_options_.color_palete_.begin();
-    // Двойной цикл, внешний - по автобусам
-    for (const auto& cur_bus_data : all_buses_data ) {
-        const domain::Bus* bus_cur = cur_bus_data.second;
-        // Если остановок нет, то рисовать нечего, переходим к следующему автобусу
-        if (bus_cur->stops_on_route.empty()) {
-            continue;
-        }
-        // Остановки ест => формируем линию маршрута
-        svg::Polyline route_line = MakeRouteLine(bus_cur->stops_on_route, coord_projector, *color_it, render_options_.line_width_);
-
-        // Добавляем линию на рисунок (к документу)
-        map_document_.Add(route_line);
-
-        // Переходим к следующему цвету линии, перебирая цвета "по кругу"
-        if (++color_it == render_options_.color_palete_.end()) {
-            color_it = render_options_.color_palete_.begin();
-        }
-    }
-    return;
-}
-
 // Формирует надпись для автобуса в виде пары элементов: 
 // first - подложка, second - надпись
 Label MapRenderer::MakeBusLable(const std::string& text, const geo::Coordinates& coordinates, const detail::SphereProjector& projector, const svg::Color& text_color) const {
@@ -107,41 +105,35 @@ Label MapRenderer::MakeBusLable(const std::string& text, const geo::Coordinates&
 }
 
 
-// Формирует названия автобусов и добавляет их в документ
-void MapRenderer::DrawBusLables(const std::vector<std::pair<std::string_view, const domain::Bus*>>& all_buses_data, const detail::SphereProjector& coord_projector) {
-    // 0. Задаем начальный цвет
-    auto color_it = render_options_.color_palete_.begin();
-    // 1. Идем по автобусам
-    for (const auto& [bus_name, bus_ptr] : all_buses_data) {
-        size_t stops_count = bus_ptr->stops_on_route.size();
-        // Если остановок нет, то и выводить название автобуса не требуется
-        if (stops_count == 0) {
-            continue;
-        }
-
-        std::string first_stop_name = bus_ptr->stops_on_route.at(0)->name;
-        
-        Label first_lable = MakeBusLable(std::string(bus_name), bus_ptr->stops_on_route.at(0)->coordinates, coord_projector, *color_it);
-        std::string last_stop_name = bus_ptr->stops_on_route.at(stops_count/2)->name;
-
-        // Добавляем на рисунок-документ
-        map_document_.Add(first_lable.underlayer);
-        map_document_.Add(first_lable.text);
-
-        // Отрисовываем конечную остановку, если она не совпадает с начальной
-        if (!bus_ptr->is_round && (last_stop_name != first_stop_name)) {
-            
-            Label last_lable = MakeBusLable(std::string(bus_name), bus_ptr->stops_on_route.at(stops_count/2)->coordinates, coord_projector, *color_it);
-            // Добавляем на рисунок-документ
-            map_document_.Add(last_lable.underlayer);
-            map_document_.Add(last_lable.text);
-        }
-
-        // Переходим к следующему цвету линии, перебирая цвета "по кругу"
-        if (++color_it == render_options_.color_palete_.end()) {
-            color_it = render_options_.color_palete_.begin();
-        }
+// Отрисовывает линию и названия маршрута цветом с номером color_index
+void MapRenderer::DrawBus(const domain::Bus& bus, size_t color_index, const detail::SphereProjector& coord_projector, const StopGetter& get_stop) {
+    const svg::Color& color = render_options_.color_palete_[color_index];
+    BusLayers layers;
+    layers.color_index = color_index;
+
+    // Линия маршрута
+    std::ostringstream route_stream;
+    RenderToStream(MakeRouteLine(bus, coord_projector, get_stop, color, render_options_.line_width_), route_stream);
+    layers.route_line = route_stream.str();
+
+    // Названия маршрута на конечных
+    const domain::Stop* first_stop = get_stop(bus.stops.front());
+    std::ostringstream labels_stream;
+    Label first_lable = MakeBusLable(bus.name, first_stop->coordinates, coord_projector, color);
+    RenderToStream(first_lable.underlayer, labels_stream);
+    RenderToStream(first_lable.text, labels_stream);
+
+    // конечная некольцевого маршрута - последняя остановка прямого хода,
+    // отрисовываем её, если она не совпадает с начальной
+    const domain::Stop* last_stop = get_stop(bus.stops.back());
+    if (!bus.is_round && (last_stop->name != first_stop->name)) {
+        Label last_lable = MakeBusLable(bus.name, last_stop->coordinates, coord_projector, color);
+        RenderToStream(last_lable.underlayer, labels_stream);
+        RenderToStream(last_lable.text, labels_stream);
     }
+    layers.labels = labels_stream.str();
+
+    bus_layers_[bus.id] = std::move(layers);
 }
 
 
@@ -157,16 +149,6 @@ svg::Circle MapRenderer::MakeOneStopCircle(const geo::Coordinates coordinates, c
     return stop_circle;
 }
 
-// Добавляет кружки остановок на рисунок.
-// На вход принимает вектор указателей на остановки. 
-// До применения этого метода остановки должны быть отсортированы нужным Пользователю образом
-void MapRenderer::DrawStops(const std::vector<const domain::Stop*>& stops, const detail::SphereProjector& coord_projector) {
-    for (const auto& stop : stops) {
-        svg::Circle stop_circle = MakeOneStopCircle(stop->coordinates, coord_projector);
-        map_document_.Add(stop_circle);
-    }
-}
-
 Label MapRenderer::MakeOneStopLable(const std::string& stop_name, const geo::Coordinates coordinates, const detail::SphereProjector& projector) const {
     svg::Text stop_underlayer;
     svg::Text stop_text;
@@ -202,37 +184,66 @@ Label MapRenderer::MakeOneStopLable(const std::string& stop_name, const geo::Coo
 
 }
 
-// Формирует названия остановок и добавляет их в документ (на рисунок)
-void MapRenderer::DrawStopLables(const std::vector<const domain::Stop*>& stops, const detail::SphereProjector& coord_projector) {
-    for (const auto& stop : stops) {
-        Label stop_label = MakeOneStopLable(stop->name, stop->coordinates, coord_projector);
-        map_document_.Add(stop_label.underlayer);
-        map_document_.Add(stop_label.text);
-    }
+// Отрисовывает кружок и название остановки
+void MapRenderer::DrawStop(const domain::Stop& stop, const detail::SphereProjector& coord_projector) {
+    StopLayers layers;
+
+    std::ostringstream circle_stream;
+    RenderToStream(MakeOneStopCircle(stop.coordinates, coord_projector), circle_stream);
+    layers.circle = circle_stream.str();
+
+    std::ostringstream label_stream;
+    Label stop_label = MakeOneStopLable(stop.name, stop.coordinates, coord_projector);
+    RenderToStream(stop_label.underlayer, label_stream);
+    RenderToStream(stop_label.text, label_stream);
+    layers.label = label_stream.str();
+
+    stop_layers_[stop.id] = std::move(layers);
 }
 
 /*
-Добавляет все объекты в документ (рисунки маршрутов, остановок, тексты)
+Формирует карту из маршрутов и остановок, заново отрисовываются только изменившиеся.
 Требование: должен быть сформирован вектор остановок all_stops, 
 которые должны присутствовать на карте.
 Фильтрация остановок (какие рисовать, какие нет) - на совести Пользователя
 */
-void MapRenderer::DrawMap(const std::vector<const domain::Stop*>& all_stops, const std::vector<std::pair<std::string_view, const domain::Bus*>>& all_buses) {
+void MapRenderer::DrawMap(const std::vector<const domain::Stop*>& all_stops, const std::vector<std::pair<std::string_view, const domain::Bus*>>& all_buses, const StopGetter& get_stop) {
     // Сформировать вектор остановок по которым строить SphereProjector
     detail::SphereProjector projector = ConfigureCoordinateProjector(all_stops);
+    // При смене масштаба или сдвиге карты меняются координаты всех объектов
+    if (!projector_ || !(*projector_ == projector)) {
+        ClearLayers();
+        projector_ = projector;
+    }
     
-    // Отрисовать маршруты  
-    DrawRoutes(all_buses, projector);
-    
-    // Отрисовть названия маршрутов
-    DrawBusLables(all_buses, projector);
-    
-    // Отрисовать остановки
-    DrawStops(all_stops, projector); 
+    // Маршруты: цвета перебираются "по кругу" только по маршрутам с остановками, 
+    // поэтому при добавлении или удалении маршрута цвет следующих за ним меняется
+    drawn_buses_.clear();
+    size_t color_index = 0;
+    for (const auto& [bus_name, bus_ptr] : all_buses) {
+        // Если остановок нет, то рисовать нечего, переходим к следующему автобусу
+        if (bus_ptr->stops.empty()) {
+            continue;
+        }
+        const auto layers_it = bus_layers_.find(bus_ptr->id);
+        if (layers_it == bus_layers_.end() || layers_it->second.color_index != color_index) {
+            DrawBus(*bus_ptr, color_index, projector, get_stop);
+        }
+        drawn_buses_.push_back(bus_ptr->id);
 
-    // Отрисовать названия остановок
-    DrawStopLables(all_stops, projector);
-   
+        if (++color_index == render_options_.color_palete_.size()) {
+            color_index = 0;
+        }
+    }
+    
+    // Остановки
+    drawn_stops_.clear();
+    for (const domain::Stop* stop_ptr : all_stops) {
+        if (!stop_layers_.count(stop_ptr->id)) {
+            DrawStop(*stop_ptr, projector);
+        }
+        drawn_stops_.push_back(stop_ptr->id);
+    }
 }
 
 
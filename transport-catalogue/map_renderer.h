@@ -5,6 +5,11 @@
 
 #include <algorithm>
 #include <cstdlib>
+#include <functional>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 
 /*
@@ -104,6 +109,12 @@ public:
         }
     }
 
+    // Проекторы равны, если переводят любые координаты в одни и те же точки
+    bool operator==(const SphereProjector& other) const {
+        return padding_ == other.padding_ && min_lon_ == other.min_lon_ 
+            && max_lat_ == other.max_lat_ && zoom_coeff_ == other.zoom_coeff_;
+    }
+
     // Проецирует широту и долготу в координаты внутри SVG-изображения
     svg::Point operator()(geo::Coordinates coords) const {
         return {
@@ -162,45 +173,95 @@ struct RenderingFormatOptions{
 };
 
 
-// Основной класс для отрисовки маршрута
+// Возвращает остановку по её id: маршруты хранят только id остановок,
+// а сам отрисовщик от каталога не зависит
+using StopGetter = std::function<const domain::Stop*(domain::StopId)>;
+
+
+/*
+Основной класс для отрисовки маршрута.
+
+Карта собирается из слоев: линии маршрутов, названия маршрутов, кружки остановок, названия остановок.
+Каждый маршрут и каждая остановка отрисовываются в svg-текст один раз и хранятся до тех пор,
+пока не изменятся (MarkBusDirty, MarkStopDirty), не сменятся параметры отрисовки 
+или масштаб карты. Повторный запрос карты только склеивает готовые фрагменты
+*/
 class MapRenderer {
 public:
-    // Формирует svg из набора элементов/рисунков/объектов типа Object
+    // Выводит svg-документ карты, сформированной последним вызовом DrawMap
     void Render(std::ostream& output) const;
     
     /*
-    Добавляет все объекты в документ (рисунки маршрутов, остановок, тексты)
+    Формирует карту из маршрутов и остановок (рисунки маршрутов, остановок, тексты),
+    заново отрисовываются только изменившиеся маршруты и остановки.
     Требование: должен быть сформирован вектор остановок all_stops, 
     которые должны присутствовать на карте.
     Фильтрация остановок (какие рисовать, какие нет) - на совести Пользователя
     */
     void DrawMap(const std::vector<const domain::Stop*>& all_stops, 
-                const std::vector<std::pair<std::string_view, const domain::Bus*>>& all_buses);
+                const std::vector<std::pair<std::string_view, const domain::Bus*>>& all_buses,
+                const StopGetter& get_stop);
 
     /*
     Сохраняет параметры форматирования: формат линий, заливки, размеры и т.п.
     */
     void SetFormatOptions(RenderingFormatOptions render_options) {
         render_options_ = std::move(render_options);
+        ClearLayers();
+    }
+
+    // Помечает маршрут как изменившийся: при следующем DrawMap он будет отрисован заново
+    void MarkBusDirty(domain::BusId bus_id) {
+        bus_layers_.erase(bus_id);
+    }
+
+    // Помечает остановку как изменившуюся: при следующем DrawMap она будет отрисована заново
+    void MarkStopDirty(domain::StopId stop_id) {
+        stop_layers_.erase(stop_id);
     }
     
 
 
 private:   
-    // Хранит массив объектов для рисования (Render)
-    svg::Document map_document_;
+    // Отрисованные слои одного маршрута
+    struct BusLayers {
+        size_t color_index = 0;   // номер цвета палитры, которым отрисован маршрут
+        std::string route_line;   // svg-текст линии маршрута
+        std::string labels;       // svg-текст названий маршрута на конечных
+    };
+
+    // Отрисованные слои одной остановки
+    struct StopLayers {
+        std::string circle;       // svg-текст кружка остановки
+        std::string label;        // svg-текст названия остановки
+    };
 
     // Хранит параметры рисования-отображения карты
     RenderingFormatOptions render_options_;
 
-    // Формирует линии маршрутов и добавляет их в документ
-    void DrawRoutes(const std::vector<std::pair<std::string_view, const domain::Bus*>>& all_buses_data, const detail::SphereProjector& coord_projector);
+    // Проектор, с которым отрисованы слои
+    std::optional<detail::SphereProjector> projector_;
+    std::unordered_map<domain::BusId, BusLayers> bus_layers_;
+    std::unordered_map<domain::StopId, StopLayers> stop_layers_;
+
+    // Маршруты и остановки текущей карты в порядке вывода
+    std::vector<domain::BusId> drawn_buses_;
+    std::vector<domain::StopId> drawn_stops_;
+
+    void ClearLayers() {
+        projector_.reset();
+        bus_layers_.clear();
+        stop_layers_.clear();
+    }
+
+    // Отрисовывает линию и названия маршрута цветом с номером color_index
+    void DrawBus(const domain::Bus& bus, size_t color_index, const detail::SphereProjector& coord_projector, const StopGetter& get_stop);
 
-    // Формирует линию для одного маршрута
-    svg::Polyline MakeRouteLine(const std::vector<const domain::Stop*>& stops, const detail::SphereProjector& projector, svg::Color line_color, double line_width) const; 
+    // Формирует линию для одного маршрута (с учетом обратного хода некольцевого маршрута)
+    svg::Polyline MakeRouteLine(const domain::Bus& bus, const detail::SphereProjector& projector, const StopGetter& get_stop, svg::Color line_color, double line_width) const; 
 
-    // Формирует названия автобусов и добавляет их в документ
-    void DrawBusLables(const std::vector<std::pair<std::string_view, const domain::Bus*>>& all_buses_data, const detail::SphereProjector& coord_projector);
+    // Отрисовывает кружок и название остановки
+    void DrawStop(const domain::Stop& stop, const detail::SphereProjector& coord_projector);
 
     // Формирует заданный текст в заданных герграфических координатах
     svg::Text MakeOneLable(const std::string& text, const geo::Coordinates& coordinates, const detail::SphereProjector& projector);
@@ -212,14 +273,8 @@ private:
     /* // Меняет цвет на следующий по круговому правилу
     void ChangeColor(std::vector<svg::Color>::iterator color_it) const;
  */
-    // Добавляет кружки остановок
-    void DrawStops(const std::vector<const domain::Stop*>& stops, const detail::SphereProjector& coord_projector);
-
     svg::Circle MakeOneStopCircle(const geo::Coordinates coordinates, const detail::SphereProjector& projector) const;    
 
-    // Формирует названия остановок и добавляет их в документ (на рисунок)
-    void DrawStopLables(const std::vector<const domain::Stop*>& stops, const detail::SphereProjector& coord_projector);
-
     Label MakeOneStopLable(const std::string& text, const geo::Coordinates coordinates, const detail::SphereProjector& projector) const; 
 
     // Формирует правило преобразования (масштабирования) координат  
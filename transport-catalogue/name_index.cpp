@@ -0,0 +1,306 @@
+#include "name_index.h"
+
+#include <algorithm>
+#include <queue>
+
+using namespace search;
+
+
+RadixTrie::RadixTrie(std::vector<WeightedName> names)
+    : entries_(std::move(names)) {
+    // Сортируем по имени, при совпадении имен оставляем вариант с наибольшим весом
+    std::sort(entries_.begin(), entries_.end(), [](const WeightedName& lhs, const WeightedName& rhs) {
+        return lhs.name < rhs.name || (lhs.name == rhs.name && lhs.weight > rhs.weight);
+    });
+    entries_.erase(std::unique(entries_.begin(), entries_.end(), [](const WeightedName& lhs, const WeightedName& rhs) {
+        return lhs.name == rhs.name;
+    }), entries_.end());
+
+    // Корень - узел с пустой меткой, существует всегда
+    nodes_.emplace_back();
+    BuildNode(0, 0, entries_.size(), 0);
+}
+
+
+// Строит поддерево для имен entries_[lo, hi), у которых совпадают первые depth символов.
+// Метка узла - общий префикс всех имен отрезка начиная с позиции depth
+void RadixTrie::BuildNode(uint32_t node_index, size_t lo, size_t hi, size_t depth) {
+    if (lo == hi) {
+        return;
+    }
+    // Имена отсортированы, поэтому общий префикс отрезка - это общий префикс первого и последнего
+    size_t node_end = depth;
+    if (node_index != 0) {
+        const std::string_view first = entries_[lo].name;
+        const std::string_view last = entries_[hi - 1].name;
+        const size_t max_len = std::min(first.size(), last.size());
+        node_end = static_cast<size_t>(std::mismatch(first.begin() + depth, first.begin() + max_len,
+                                                     last.begin() + depth).first - first.begin());
+        nodes_[node_index].label = first.substr(depth, node_end - depth);
+    }
+
+    // Имя, совпадающее с путем до узла, - единственное и стоит первым
+    if (entries_[lo].name.size() == node_end) {
+        nodes_[node_index].entry = static_cast<uint32_t>(lo);
+        nodes_[node_index].best_entry = static_cast<uint32_t>(lo);
+        ++lo;
+    }
+
+    // Группируем оставшиеся имена по символу на позиции node_end: каждая группа - один потомок.
+    // Имена отсортированы по байтам без знака, в том же порядке идут и потомки (см. FindByPrefix)
+    std::vector<std::pair<size_t, size_t>> groups;
+    for (size_t group_lo = lo; group_lo < hi;) {
+        const char ch = entries_[group_lo].name[node_end];
+        size_t group_hi = group_lo + 1;
+        while (group_hi < hi && entries_[group_hi].name[node_end] == ch) {
+            ++group_hi;
+        }
+        groups.emplace_back(group_lo, group_hi);
+        group_lo = group_hi;
+    }
+
+    // Потомки занимают непрерывный отрезок в nodes_ (ссылки на узлы не храним - вектор растет)
+    const uint32_t first_child = static_cast<uint32_t>(nodes_.size());
+    nodes_[node_index].first_child = first_child;
+    nodes_[node_index].child_count = static_cast<uint32_t>(groups.size());
+    nodes_.resize(nodes_.size() + groups.size());
+
+    for (size_t i = 0; i < groups.size(); ++i) {
+        const uint32_t child_index = first_child + static_cast<uint32_t>(i);
+        BuildNode(child_index, groups[i].first, groups[i].second, node_end);
+        const uint32_t child_best = nodes_[child_index].best_entry;
+        if (nodes_[node_index].best_entry == NO_ENTRY || IsBetterEntry(child_best, nodes_[node_index].best_entry)) {
+            nodes_[node_index].best_entry = child_best;
+        }
+    }
+}
+
+
+bool RadixTrie::IsBetterEntry(uint32_t lhs, uint32_t rhs) const {
+    if (entries_[lhs].weight != entries_[rhs].weight) {
+        return entries_[lhs].weight > entries_[rhs].weight;
+    }
+    return lhs < rhs;
+}
+
+
+std::vector<std::string_view> RadixTrie::FindByPrefix(std::string_view prefix, size_t limit) const {
+    std::vector<std::string_view> result;
+    if (limit == 0 || nodes_[0].best_entry == NO_ENTRY) {
+        return result;
+    }
+
+    // 1. Спускаемся по дереву, пока префикс не закончится (возможно, посреди метки узла)
+    uint32_t node_index = 0;
+    size_t matched = 0;
+    while (matched < prefix.size()) {
+        const Node& node = nodes_[node_index];
+        const auto children_begin = nodes_.begin() + node.first_child;
+        const auto children_end = children_begin + node.child_count;
+        const char ch = prefix[matched];
+        // потомки упорядочены как имена при сортировке строк - по байтам без знака (важно для UTF-8)
+        const auto child_it = std::lower_bound(children_begin, children_end, ch, [](const Node& child, char value) {
+            return static_cast<unsigned char>(child.label.front()) < static_cast<unsigned char>(value);
+        });
+        if (child_it == children_end || child_it->label.front() != ch) {
+            return result;
+        }
+        const std::string_view rest = prefix.substr(matched);
+        const size_t common = std::min(rest.size(), child_it->label.size());
+        if (rest.substr(0, common) != child_it->label.substr(0, common)) {
+            return result;
+        }
+        matched += common;
+        node_index = static_cast<uint32_t>(child_it - nodes_.begin());
+    }
+
+    // 2. Best-first обход поддерева: в очереди лежат узлы (ключ - лучшее имя поддерева)
+    // и отдельные имена. Лучшее имя поддерева достижимо, поэтому имена извлекаются в порядке выдачи
+    struct QueueItem {
+        uint32_t key_entry;
+        uint32_t node_index;
+        bool is_entry;
+    };
+    auto worse = [this](const QueueItem& lhs, const QueueItem& rhs) {
+        return IsBetterEntry(rhs.key_entry, lhs.key_entry);
+    };
+    std::priority_queue<QueueItem, std::vector<QueueItem>, decltype(worse)> queue(worse);
+    queue.push({nodes_[node_index].best_entry, node_index, false});
+
+    while (!queue.empty() && result.size() < limit) {
+        const QueueItem item = queue.top();
+        queue.pop();
+        if (item.is_entry) {
+            result.push_back(entries_[item.key_entry].name);
+            continue;
+        }
+        const Node& node = nodes_[item.node_index];
+        if (node.entry != NO_ENTRY) {
+            queue.push({node.entry, item.node_index, true});
+        }
+        for (uint32_t child = node.first_child; child < node.first_child + node.child_count; ++child) {
+            queue.push({nodes_[child].best_entry, child, false});
+        }
+    }
+    return result;
+}
+
+
+bool Utf8Decoder::Feed(char byte, char32_t& code_point) {
+    const unsigned char value = static_cast<unsigned char>(byte);
+    const bool is_continuation = (value & 0xC0) == 0x80;
+    if (pending_bytes > 0) {
+        if (is_continuation) {
+            partial = (partial << 6) | (value & 0x3F);
+            if (--pending_bytes == 0) {
+                code_point = partial;
+                return true;
+            }
+            return false;
+        }
+        // последовательность оборвалась - байт разбирается как начало нового символа
+        pending_bytes = 0;
+    }
+    if (value < 0x80) {
+        code_point = value;
+        return true;
+    }
+    if ((value & 0xE0) == 0xC0) {
+        partial = value & 0x1F;
+        pending_bytes = 1;
+    }
+    else if ((value & 0xF0) == 0xE0) {
+        partial = value & 0x0F;
+        pending_bytes = 2;
+    }
+    else if ((value & 0xF8) == 0xF0) {
+        partial = value & 0x07;
+        pending_bytes = 3;
+    }
+    else {
+        // одиночный байт продолжения или недопустимый байт - отдельный символ вне диапазона Unicode
+        code_point = 0x110000 + value;
+        return true;
+    }
+    return false;
+}
+
+
+std::u32string search::DecodeUtf8(std::string_view text) {
+    std::u32string code_points;
+    code_points.reserve(text.size());
+    Utf8Decoder decoder;
+    char32_t code_point = 0;
+    for (const char byte : text) {
+        if (decoder.Feed(byte, code_point)) {
+            code_points.push_back(code_point);
+        }
+    }
+    return code_points;
+}
+
+
+void RadixTrie::CollectSimilar(uint32_t node_index, std::u32string_view query, size_t max_typos, size_t depth,
+                               Utf8Decoder decoder, std::vector<size_t>& rows,
+                               std::vector<std::pair<size_t, uint32_t>>& found) const {
+    const size_t width = query.size() + 1;
+    const Node& node = nodes_[node_index];
+
+    // Для каждого символа метки (байты собираются в символы UTF-8) считаем очередную строку таблицы расстояний
+    char32_t ch = 0;
+    for (const char byte : node.label) {
+        if (!decoder.Feed(byte, ch)) {
+            continue;
+        }
+        if (rows.size() < (depth + 2) * width) {
+            rows.resize((depth + 2) * width);
+        }
+        const size_t prev = depth * width;
+        const size_t cur = prev + width;
+        rows[cur] = rows[prev] + 1;
+        size_t row_min = rows[cur];
+        for (size_t j = 1; j < width; ++j) {
+            const size_t substitution = rows[prev + j - 1] + (query[j - 1] == ch ? 0 : 1);
+            rows[cur + j] = std::min({rows[prev + j] + 1, rows[cur + j - 1] + 1, substitution});
+            row_min = std::min(row_min, rows[cur + j]);
+        }
+        ++depth;
+        // Расстояние вдоль ветви не убывает - дальше искать бессмысленно
+        if (row_min > max_typos) {
+            return;
+        }
+    }
+
+    if (node.entry != NO_ENTRY) {
+        const size_t distance = rows[depth * width + width - 1];
+        if (distance <= max_typos) {
+            found.emplace_back(distance, node.entry);
+        }
+    }
+    for (uint32_t child = node.first_child; child < node.first_child + node.child_count; ++child) {
+        CollectSimilar(child, query, max_typos, depth, decoder, rows, found);
+    }
+}
+
+
+std::vector<std::string_view> RadixTrie::FindSimilar(std::string_view query, size_t max_typos, size_t limit) const {
+    std::vector<std::string_view> result;
+    if (limit == 0 || entries_.empty()) {
+        return result;
+    }
+
+    // Таблица расстояний строится по символам, а не по байтам: иначе одна кириллическая буква - две правки
+    const std::u32string query_code_points = DecodeUtf8(query);
+    // Начальная строка таблицы: расстояние от пустой строки до префиксов запроса
+    std::vector<size_t> rows(query_code_points.size() + 1);
+    for (size_t j = 0; j < rows.size(); ++j) {
+        rows[j] = j;
+    }
+    std::vector<std::pair<size_t, uint32_t>> found;
+    CollectSimilar(0, query_code_points, max_typos, 0, Utf8Decoder{}, rows, found);
+
+    std::sort(found.begin(), found.end(), [this](const auto& lhs, const auto& rhs) {
+        if (lhs.first != rhs.first) {
+            return lhs.first < rhs.first;
+        }
+        return IsBetterEntry(lhs.second, rhs.second);
+    });
+    const size_t count = std::min(limit, found.size());
+    result.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        result.push_back(entries_[found[i].second].name);
+    }
+    return result;
+}
+
+
+NameIndex::NameIndex(std::vector<WeightedName> stop_names, std::vector<WeightedName> bus_names)
+    : stops_trie_(std::move(stop_names))
+    , buses_trie_(std::move(bus_names)) {
+}
+
+
+// Дополняет список подсказок по префиксу похожими именами (без повторов) до limit штук
+static std::vector<std::string_view> SuggestFromTrie(const RadixTrie& trie, std::string_view query,
+                                                     size_t limit, size_t max_typos) {
+    std::vector<std::string_view> result = trie.FindByPrefix(query, limit);
+    if (max_typos == 0 || result.size() >= limit) {
+        return result;
+    }
+    // Похожих имен запрашиваем с запасом: часть из них уже есть среди найденных по префиксу
+    for (std::string_view name : trie.FindSimilar(query, max_typos, limit + result.size())) {
+        if (result.size() >= limit) {
+            break;
+        }
+        if (std::find(result.begin(), result.end(), name) == result.end()) {
+            result.push_back(name);
+        }
+    }
+    return result;
+}
+
+
+Suggestions NameIndex::Suggest(std::string_view query, size_t limit, size_t max_typos) const {
+    return {SuggestFromTrie(stops_trie_, query, limit, max_typos),
+            SuggestFromTrie(buses_trie_, query, limit, max_typos)};
+}
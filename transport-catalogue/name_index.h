@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/*
+ * Индекс названий остановок и маршрутов для подсказок (автодополнения).
+ *
+ * Названия хранятся в сжатом префиксном дереве (radix trie): цепочки узлов с единственным
+ * потомком склеены в одно ребро, метка ребра - string_view на интернированное в каталоге имя,
+ * поэтому сами строки не копируются. Узлы лежат в одном векторе, потомки каждого узла -
+ * непрерывным отрезком, отсортированным по первому символу метки.
+ *
+ * Поддерживаются два вида поиска:
+ *  - перечисление имен с заданным префиксом, k лучших по весу (best-first по максимальному
+ *    весу поддерева, поэтому обходится только нужная часть дерева);
+ *  - поиск имен, отличающихся от запроса не более чем на max_typos правок (расстояние Левенштейна
+ *    по символам UTF-8, а не по байтам), с отсечением ветвей по строке динамического программирования.
+ */
+
+namespace search {
+
+// Имя с весом (для остановки - число автобусов, для маршрута - число уникальных остановок)
+struct WeightedName {
+    std::string_view name;
+    uint32_t weight = 0;
+};
+
+
+/*
+Пошаговый разбор UTF-8 по байтам. Метки дерева режутся по байтам, поэтому символ может начинаться
+в метке узла и заканчиваться в метке потомка. Байт, который не может быть началом символа,
+считается отдельным символом, незаконченная последовательность отбрасывается
+*/
+struct Utf8Decoder {
+    // Принимает очередной байт. Возвращает true, если символ закончился (он записывается в code_point)
+    bool Feed(char byte, char32_t& code_point);
+
+    char32_t partial = 0;
+    int pending_bytes = 0;
+};
+
+// Символы строки UTF-8 (см. Utf8Decoder)
+std::u32string DecodeUtf8(std::string_view text);
+
+
+class RadixTrie {
+public:
+    RadixTrie() = default;
+
+    // Строит дерево по набору имен. Имена должны жить дольше дерева, дубликаты игнорируются
+    explicit RadixTrie(std::vector<WeightedName> names);
+
+    // Возвращает не более limit имен, начинающихся с prefix.
+    // Порядок: по убыванию веса, при равном весе - по алфавиту
+    std::vector<std::string_view> FindByPrefix(std::string_view prefix, size_t limit) const;
+
+    // Возвращает не более limit имен на расстоянии редактирования не больше max_typos от query
+    // (правки считаются по символам UTF-8: замена кириллической буквы - одна правка).
+    // Порядок: по возрастанию расстояния, затем по убыванию веса, затем по алфавиту
+    std::vector<std::string_view> FindSimilar(std::string_view query, size_t max_typos, size_t limit) const;
+
+    size_t GetNamesCount() const {
+        return entries_.size();
+    }
+
+private:
+    static constexpr uint32_t NO_ENTRY = UINT32_MAX;
+
+    struct Node {
+        std::string_view label;        // метка ребра, ведущего в узел
+        uint32_t first_child = 0;      // индекс первого потомка в nodes_
+        uint32_t child_count = 0;
+        uint32_t entry = NO_ENTRY;     // индекс имени в entries_, если узел терминальный
+        uint32_t best_entry = NO_ENTRY;  // лучшее имя поддерева (максимальный вес, затем минимальный ранг)
+    };
+
+    // entries_ отсортированы по имени, поэтому индекс имени - это его алфавитный ранг
+    std::vector<WeightedName> entries_;
+    std::vector<Node> nodes_;
+
+    // Строит поддерево для имен entries_[lo, hi), у которых совпадают первые depth символов
+    void BuildNode(uint32_t node_index, size_t lo, size_t hi, size_t depth);
+
+    // true, если имя с индексом lhs должно идти раньше rhs в выдаче
+    bool IsBetterEntry(uint32_t lhs, uint32_t rhs) const;
+
+    // Обходит поддерево узла, поддерживая строки таблицы расстояний Левенштейна:
+    // rows хранит строки для каждой глубины подряд, depth - число уже разобранных символов,
+    // decoder - разбор символа, начатого в метках предков
+    void CollectSimilar(uint32_t node_index, std::u32string_view query, size_t max_typos, size_t depth,
+                        Utf8Decoder decoder, std::vector<size_t>& rows,
+                        std::vector<std::pair<size_t, uint32_t>>& found) const;
+};
+
+
+// Результат поиска подсказок по названиям
+struct Suggestions {
+    std::vector<std::string_view> stops;
+    std::vector<std::string_view> buses;
+};
+
+
+// Индекс всех названий каталога: отдельные деревья для остановок и для маршрутов
+class NameIndex {
+public:
+    NameIndex(std::vector<WeightedName> stop_names, std::vector<WeightedName> bus_names);
+
+    /*
+    Возвращает подсказки для строки query: сначала имена, начинающиеся с query,
+    затем (если max_typos > 0) имена на расстоянии не больше max_typos правок.
+    В каждом списке не более limit имен, без повторов
+    */
+    Suggestions Suggest(std::string_view query, size_t limit, size_t max_typos) const;
+
+private:
+    RadixTrie stops_trie_;
+    RadixTrie buses_trie_;
+};
+
+}  // namespace search
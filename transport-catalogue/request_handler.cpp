@@ -1,5 +1,7 @@
 #include "request_handler.h"
 
+#include <stdexcept>
+
 /*
  * Здесь можно было бы разместить код обработчика запросов к базе, содержащего логику, которую не
  * хотелось бы помещать ни в transport_catalogue, ни в json reader.
@@ -27,6 +29,14 @@ std::optional<domain::StopInfo> RequestHandler::GetBusesByStop(const std::string
     return db_.GetStopInfo(stop_name);
 }
 
+std::optional<domain::BusInfo> RequestHandler::GetBusStatById(domain::BusId bus_id) const {
+    return db_.GetBusInfoById(bus_id);
+}
+
+std::optional<domain::StopInfo> RequestHandler::GetBusesByStopId(domain::StopId stop_id) const {
+    return db_.GetStopInfoById(stop_id);
+}
+
 /*
 Возвращает вектор всех автобусов в сортированном порядке
 */
@@ -39,10 +49,13 @@ std::vector<const domain::Stop*> RequestHandler::GetAllStopsForMap() const {
 }
 
 void RequestHandler::RenderMap(std::ostream& ouput_stream) {
+    std::lock_guard<std::mutex> guard(map_mutex_);
     std::vector<const domain::Stop*> stops_to_draw = GetAllStopsForMap();
     std::vector<std::pair<std::string_view, const domain::Bus*>> routes_to_draw = GetAllBusesForMap();
     // Формируем документ
-    map_renderer_.DrawMap(stops_to_draw, routes_to_draw);
+    map_renderer_.DrawMap(stops_to_draw, routes_to_draw, [this](domain::StopId stop_id) {
+        return db_.GetStopById(stop_id);
+    });
     // Отрисовываем документ
     map_renderer_.Render(ouput_stream);
 }
@@ -57,4 +70,40 @@ const transport::TransportCatalogue& RequestHandler::GetTransportCatalogue() con
 
 std::optional<int> RequestHandler::GetDistanceBetweenAdjacentStops(std::string_view stop_A_name, std::string_view stop_B_name) const {
     return db_.GetDistanceBetweenStops(stop_A_name, stop_B_name);
-}
\ No newline at end of file
+}
+
+void RequestHandler::SetRouter(routing::TransportRouter* router) {
+    router_ = router;
+}
+
+std::vector<routing::TransportRouteInfo> RequestHandler::GetRoutes(const std::vector<routing::RouteQuery>& queries, parallel::ThreadPool* thread_pool) const {
+    if (!router_) {
+        throw std::logic_error("LOG err: in GetRoutes - Router is not set");
+    }
+    return router_->GetRoutesInfo(queries, thread_pool);
+}
+
+routing::TransportRouteInfo RequestHandler::GetRoute(std::string_view from_stop, std::string_view to_stop) const {
+    if (!router_) {
+        throw std::logic_error("LOG err: in GetRoute - Router is not set");
+    }
+    return router_->GetRouteInfo(from_stop, to_stop);
+}
+
+void RequestHandler::OnCatalogueChanged(const transport::CatalogueChange& change) {
+    using Type = transport::CatalogueChange::Type;
+    // Расстояния на карте не отображаются
+    if (change.type != Type::DISTANCE_CHANGED) {
+        for (const domain::Bus* bus_ptr : change.buses) {
+            map_renderer_.MarkBusDirty(bus_ptr->id);
+        }
+        if (change.type == Type::STOP_MOVED) {
+            for (const domain::Stop* stop_ptr : change.stops) {
+                map_renderer_.MarkStopDirty(stop_ptr->id);
+            }
+        }
+    }
+    if (router_) {
+        router_->OnCatalogueChanged(change);
+    }
+}
@@ -2,6 +2,9 @@
 
 #include "transport_catalogue.h"
 #include "map_renderer.h"
+#include "transport_router.h"
+
+#include <mutex>
 
 /*
  * Здесь можно было бы разместить код обработчика запросов к базе, содержащего логику, которую не
@@ -32,6 +35,10 @@ public:
     // const std::unordered_set<BusPtr>* GetBusesByStop(const std::string_view& stop_name) const;
     std::optional<domain::StopInfo> GetBusesByStop(const std::string_view& stop_name) const;
 
+    // То же по id маршрута и остановки в каталоге, без поиска по названию
+    std::optional<domain::BusInfo> GetBusStatById(domain::BusId bus_id) const;
+    std::optional<domain::StopInfo> GetBusesByStopId(domain::StopId stop_id) const;
+
     /*
     Возвращает вектор всех маршрутов с данными об остановках в сортированном порядке по названию
     */
@@ -42,7 +49,8 @@ public:
     */
     std::vector<const domain::Stop*> GetAllStopsForMap() const;
 
-    // Этот метод будет нужен в следующей части итогового проекта
+    // Рисует карту в поток. Можно вызывать из нескольких потоков: 
+    // отрисовщик меняет свое состояние, поэтому карты рисуются по очереди
     void RenderMap(std::ostream& ouput_stream);
 
     renderer::MapRenderer& GetMaprenderer();
@@ -51,11 +59,29 @@ public:
 
     std::optional<int> GetDistanceBetweenAdjacentStops(std::string_view stop_A_name, std::string_view stop_B_name) const;
 
+    // Задает маршрутизатор, который нужно обновлять при изменении каталога (nullptr - маршрутизатора нет)
+    void SetRouter(routing::TransportRouter* router);
+
+    // Возвращает маршруты для группы запросов (в порядке запросов), 
+    // если маршрутизатор не задан, выбросит исключение logic_error
+    std::vector<routing::TransportRouteInfo> GetRoutes(const std::vector<routing::RouteQuery>& queries, parallel::ThreadPool* thread_pool = nullptr) const;
+
+    // Возвращает маршрут между двумя остановками, если маршрутизатор не задан, выбросит исключение logic_error
+    routing::TransportRouteInfo GetRoute(std::string_view from_stop, std::string_view to_stop) const;
+
+    /*
+    Пересчитывает данные, зависящие от каталога, после его изменения: 
+    помечает изменившиеся маршруты и остановки для перерисовки на карте и обновляет граф маршрутизатора.
+    Предназначен для подписки на изменения каталога (TransportCatalogue::Subscribe)
+    */
+    void OnCatalogueChanged(const transport::CatalogueChange& change);
 
 
 private:
     // RequestHandler использует агрегацию объектов "Транспортный Справочник" и "Визуализатор Карты"
     const transport::TransportCatalogue& db_;
     renderer::MapRenderer& map_renderer_;
+    routing::TransportRouter* router_ = nullptr;
+    std::mutex map_mutex_;
 
 };
@@ -8,6 +8,7 @@
 #include <cstdint>
 #include <iterator>
 #include <optional>
+#include <queue>
 #include <stdexcept>
 #include <unordered_map>
 #include <utility>
@@ -15,27 +16,83 @@
 
 namespace graph {
 
+// Способ поиска кратчайших путей
+enum class RouterMode {
+    ALL_PAIRS,      // пути между всеми парами вершин считаются при создании (алгоритм Флойда-Уоршелла)
+    SINGLE_SOURCE,  // пути из вершины ищутся при запросе (алгоритм Дейкстры), заранее ничего не считается
+};
+
 template <typename Weight>
 class Router {
 private:
     using Graph = DirectedWeightedGraph<Weight>;
 
+    struct RouteInternalData {
+        Weight weight;
+        std::optional<EdgeId> prev_edge;
+    };
+    using RoutesRow = std::vector<std::optional<RouteInternalData>>;
+
 public:
-    explicit Router(const Graph& graph);
+    explicit Router(const Graph& graph, RouterMode mode = RouterMode::ALL_PAIRS);
 
     struct RouteInfo {
         Weight weight;
         std::vector<EdgeId> edges;
     };
 
+    // Кратчайшие пути из одной вершины до всех остальных
+    class SourceRoutes {
+    public:
+        std::optional<RouteInfo> BuildRoute(VertexId to) const {
+            return BuildRouteFromRow(graph_, GetRow(), to);
+        }
+
+    private:
+        friend class Router;
+
+        // Пути - строка готовой таблицы роутера
+        SourceRoutes(const Graph& graph, const RoutesRow& table_row)
+            : graph_(graph), table_row_(&table_row) {
+        }
+
+        // Пути посчитаны отдельно и хранятся в объекте
+        SourceRoutes(const Graph& graph, RoutesRow&& own_row)
+            : graph_(graph), own_row_(std::move(own_row)) {
+        }
+
+        const RoutesRow& GetRow() const {
+            return table_row_ ? *table_row_ : own_row_;
+        }
+
+        const Graph& graph_;
+        const RoutesRow* table_row_ = nullptr;
+        RoutesRow own_row_;
+    };
+
     std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
+    /*
+    Возвращает кратчайшие пути из вершины from до всех вершин графа: 
+    в режиме ALL_PAIRS - строку готовой таблицы, в режиме SINGLE_SOURCE - результат 
+    одного запуска алгоритма Дейкстры. Нужен, чтобы отвечать на группу запросов 
+    с общим началом пути за один поиск
+    */
+    SourceRoutes BuildRoutesFrom(VertexId from) const;
+
+    /*
+    Обновляет данные о кратчайших путях после изменения ребер графа changed_edges 
+    (изменен вес, ребро удалено или добавлено, в граф могли добавиться вершины).
+    Полный пересчет не выполняется. В каждой строке (для каждого источника) таблица хранит дерево 
+    кратчайших путей: сбрасываются только вершины, путь до которых проходит через измененное ребро, 
+    и для них (а также для вершин, до которых измененное ребро дает более короткий путь) 
+    алгоритм Дейкстры запускается от границы сброшенной части. Строки, которых изменение 
+    не касается, не пересчитываются
+    */
+    void UpdateEdges(const std::vector<EdgeId>& changed_edges);
+
 private:
-    struct RouteInternalData {
-        Weight weight;
-        std::optional<EdgeId> prev_edge;
-    };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+    using RoutesInternalData = std::vector<RoutesRow>;
 
     // Формирует двумерный вектор информации о кратчайшем пути, 
     // то есть от каждого до каждого узла записывает ближайшее ребро (путь) и его вес)
@@ -78,17 +135,174 @@ private:
         }
     }
 
+    // Проверяет, могут ли кратчайшие пути из vertex_from измениться из-за изменения ребра edge_id
+    bool IsRowAffectedByEdge(VertexId vertex_from, EdgeId edge_id) const {
+        const auto& edge = graph_.GetEdge(edge_id);
+        const auto& route_to_end = routes_internal_data_[vertex_from][edge.to];
+        // 1. Ребро входит в дерево кратчайших путей из vertex_from: 
+        // все пути через edge.to восстанавливаются через его prev_edge
+        if (route_to_end && route_to_end->prev_edge == edge_id) {
+            return true;
+        }
+        // 2. Ребро (с новым весом) дает более короткий путь до своего конца
+        const auto& route_to_start = routes_internal_data_[vertex_from][edge.from];
+        if (!route_to_start) {
+            return false;
+        }
+        const Weight candidate_weight = route_to_start->weight + edge.weight;
+        return !route_to_end || candidate_weight < route_to_end->weight;
+    }
+
+    using QueueItem = std::pair<Weight, VertexId>;
+    struct IsFarther {
+        bool operator()(const QueueItem& lhs, const QueueItem& rhs) const {
+            return rhs.first < lhs.first;
+        }
+    };
+    using RoutesQueue = std::priority_queue<QueueItem, std::vector<QueueItem>, IsFarther>;
+
+    // Состояние вершины при починке строки
+    enum class VertexState : char {
+        UNKNOWN,    // еще не проверена
+        VALID,      // путь до вершины не проходит через измененные ребра
+        AFFECTED,   // путь проходит через измененное ребро, вершина сброшена
+    };
+
+    // Данные, общие для починки всех строк при одном обновлении
+    struct RepairContext {
+        std::vector<std::vector<EdgeId>> incoming_edges;  // входящие ребра каждой вершины
+        std::vector<bool> is_changed_edge;
+        std::vector<EdgeId> present_changed_edges;        // измененные ребра, оставшиеся в графе
+        std::vector<VertexState> states;
+        std::vector<VertexId> chain;
+    };
+
+    // Если путь через ребро edge_id короче записанного, записывает его и добавляет вершину в очередь
+    void TryRelaxEdge(RoutesRow& row, const RouteInternalData& route_from, EdgeId edge_id, RoutesQueue& queue) const {
+        const auto& edge = graph_.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        const Weight candidate_weight = route_from.weight + edge.weight;
+        auto& route_to = row[edge.to];
+        if (!route_to || candidate_weight < route_to->weight) {
+            route_to = RouteInternalData{candidate_weight, edge_id};
+            queue.push({candidate_weight, edge.to});
+        }
+    }
+
+    // Алгоритм Дейкстры по строке: в очереди - вершины, чьи пути записаны, но исходящие ребра не просмотрены
+    void RunDijkstra(RoutesRow& row, RoutesQueue& queue) const {
+        while (!queue.empty()) {
+            const auto [weight, vertex] = queue.top();
+            queue.pop();
+            // в очереди могла остаться устаревшая (более длинная) запись
+            if (row[vertex]->weight < weight) {
+                continue;
+            }
+            const RouteInternalData route_from = *row[vertex];
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                TryRelaxEdge(row, route_from, edge_id, queue);
+            }
+        }
+    }
+
+    // Считает кратчайшие пути из одной вершины (строку таблицы) алгоритмом Дейкстры
+    RoutesRow ComputeRow(VertexId vertex_from) const {
+        RoutesRow row(graph_.GetVertexCount());
+        row.at(vertex_from) = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+        RoutesQueue queue;
+        queue.push({ZERO_WEIGHT, vertex_from});
+        RunDijkstra(row, queue);
+        return row;
+    }
+
+    void RecomputeRow(VertexId vertex_from) {
+        routes_internal_data_[vertex_from] = ComputeRow(vertex_from);
+    }
+
+    // Формирует кратчайший путь по строке таблицы
+    static std::optional<RouteInfo> BuildRouteFromRow(const Graph& graph, const RoutesRow& row, VertexId to);
+
+    // Чинит строку после изменения ребер: сбрасывает вершины, путь до которых проходит 
+    // через измененные ребра, и достраивает пути от несброшенной части строки
+    void RepairRow(VertexId vertex_from, RepairContext& context) {
+        auto& row = routes_internal_data_[vertex_from];
+        auto& states = context.states;
+        std::fill(states.begin(), states.end(), VertexState::UNKNOWN);
+        states[vertex_from] = VertexState::VALID;
+
+        // 1. Поднимаемся от каждой вершины по дереву путей до проверенной вершины 
+        // или до измененного ребра, все вершины цепочки получают одинаковое состояние
+        std::vector<VertexId> affected_vertexes;
+        for (VertexId vertex = 0; vertex < row.size(); ++vertex) {
+            if (!row[vertex] || states[vertex] != VertexState::UNKNOWN) {
+                continue;
+            }
+            auto& chain = context.chain;
+            chain.clear();
+            VertexState chain_state = VertexState::UNKNOWN;
+            for (VertexId cur = vertex; chain_state == VertexState::UNKNOWN; ) {
+                if (states[cur] != VertexState::UNKNOWN) {
+                    chain_state = states[cur];
+                    break;
+                }
+                chain.push_back(cur);
+                const EdgeId prev_edge = *row[cur]->prev_edge;
+                if (context.is_changed_edge[prev_edge]) {
+                    chain_state = VertexState::AFFECTED;
+                    break;
+                }
+                cur = graph_.GetEdge(prev_edge).from;
+            }
+            for (VertexId chain_vertex : chain) {
+                states[chain_vertex] = chain_state;
+            }
+            if (chain_state == VertexState::AFFECTED) {
+                affected_vertexes.insert(affected_vertexes.end(), chain.begin(), chain.end());
+            }
+        }
+
+        // 2. Сбрасываем затронутые вершины и находим для них пути через ребра из несброшенных вершин
+        for (VertexId vertex : affected_vertexes) {
+            row[vertex].reset();
+        }
+        RoutesQueue queue;
+        for (VertexId vertex : affected_vertexes) {
+            for (EdgeId edge_id : context.incoming_edges[vertex]) {
+                const VertexId prev_vertex = graph_.GetEdge(edge_id).from;
+                if (states[prev_vertex] != VertexState::AFFECTED && row[prev_vertex]) {
+                    TryRelaxEdge(row, *row[prev_vertex], edge_id, queue);
+                }
+            }
+        }
+        // 3. Измененные ребра из несброшенных вершин могут дать более короткие пути
+        for (EdgeId edge_id : context.present_changed_edges) {
+            const VertexId prev_vertex = graph_.GetEdge(edge_id).from;
+            if (states[prev_vertex] != VertexState::AFFECTED && row[prev_vertex]) {
+                TryRelaxEdge(row, *row[prev_vertex], edge_id, queue);
+            }
+        }
+
+        // 4. Распространяем найденные пути
+        RunDijkstra(row, queue);
+    }
+
     static constexpr Weight ZERO_WEIGHT{};
     const Graph& graph_;
+    RouterMode mode_;
     RoutesInternalData routes_internal_data_;
 };
 
 template <typename Weight>
-Router<Weight>::Router(const Graph& graph)
+Router<Weight>::Router(const Graph& graph, RouterMode mode)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-                            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+    , mode_(mode)
 {
+    if (mode_ == RouterMode::SINGLE_SOURCE) {
+        return;
+    }
+    routes_internal_data_.assign(graph.GetVertexCount(), RoutesRow(graph.GetVertexCount()));
     InitializeRoutesInternalData(graph);
 
     const size_t vertex_count = graph.GetVertexCount();
@@ -97,12 +311,77 @@ Router<Weight>::Router(const Graph& graph)
     }
 }
 
-// Формирует кратчайший путь индексов ребер - фактически разворачивает цепочку, начиная с информации о конечном узле
-// Сначала идет от конечного узла в начальный, затем инвертирует порядок для нормального представления 
+template <typename Weight>
+void Router<Weight>::UpdateEdges(const std::vector<EdgeId>& changed_edges) {
+    // без таблицы пути и так ищутся по текущему графу
+    if (mode_ == RouterMode::SINGLE_SOURCE) {
+        return;
+    }
+    // Расширяем таблицу, если в графе появились новые вершины
+    const size_t old_vertex_count = routes_internal_data_.size();
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (vertex_count > old_vertex_count) {
+        for (auto& row : routes_internal_data_) {
+            row.resize(vertex_count);
+        }
+        routes_internal_data_.resize(vertex_count, RoutesRow(vertex_count));
+    }
+
+    // Общие для всех строк данные: входящие ребра вершин и отметки измененных ребер
+    RepairContext context;
+    context.incoming_edges.resize(vertex_count);
+    std::vector<bool> is_present_edge(graph_.GetEdgeCount(), false);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            context.incoming_edges[graph_.GetEdge(edge_id).to].push_back(edge_id);
+            is_present_edge[edge_id] = true;
+        }
+    }
+    context.is_changed_edge.assign(graph_.GetEdgeCount(), false);
+    for (const EdgeId edge_id : changed_edges) {
+        context.is_changed_edge[edge_id] = true;
+        if (is_present_edge[edge_id]) {
+            context.present_changed_edges.push_back(edge_id);
+        }
+    }
+    context.states.resize(vertex_count);
+
+    for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
+        if (vertex_from >= old_vertex_count) {
+            // строки новых вершин считаем целиком
+            RecomputeRow(vertex_from);
+        }
+        else if (std::any_of(changed_edges.begin(), changed_edges.end(), [this, vertex_from](EdgeId edge_id) {
+                return IsRowAffectedByEdge(vertex_from, edge_id);
+            })) {
+            RepairRow(vertex_from, context);
+        }
+    }
+}
+
+template <typename Weight>
+typename Router<Weight>::SourceRoutes Router<Weight>::BuildRoutesFrom(VertexId from) const {
+    if (mode_ == RouterMode::ALL_PAIRS) {
+        return SourceRoutes(graph_, routes_internal_data_.at(from));
+    }
+    return SourceRoutes(graph_, ComputeRow(from));
+}
+
 template <typename Weight>
 std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
                                                                              VertexId to) const {
-    const auto& route_internal_data = routes_internal_data_.at(from).at(to);
+    if (mode_ == RouterMode::ALL_PAIRS) {
+        return BuildRouteFromRow(graph_, routes_internal_data_.at(from), to);
+    }
+    return BuildRoutesFrom(from).BuildRoute(to);
+}
+
+// Формирует кратчайший путь индексов ребер - фактически разворачивает цепочку, начиная с информации о конечном узле
+// Сначала идет от конечного узла в начальный, затем инвертирует порядок для нормального представления 
+template <typename Weight>
+std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRouteFromRow(const Graph& graph, 
+                                                                                    const RoutesRow& row, VertexId to) {
+    const auto& route_internal_data = row.at(to);
     if (!route_internal_data) {
         return std::nullopt;
     }
@@ -110,7 +389,7 @@ std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(Ver
     std::vector<EdgeId> edges;
     for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
          edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+         edge_id = row[graph.GetEdge(*edge_id).from]->prev_edge)
     {
         edges.push_back(*edge_id);
     }
@@ -0,0 +1,534 @@
+#include "server.h"
+#include "thread_pool.h"
+
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std::literals;
+using namespace server;
+
+
+// Проверяет, что строка состоит только из пробельных символов
+static bool IsBlankLine(std::string_view line) {
+    return line.find_first_not_of(" \t\r"sv) == line.npos;
+}
+
+void server::ServeStream(std::istream& input, std::ostream& output, const MessageHandler& handler) {
+    std::string line;
+    while (std::getline(input, line)) {
+        if (IsBlankLine(line)) {
+            continue;
+        }
+        // ответ отправляем сразу, не дожидаясь следующих запросов
+        output << handler(line) << '\n' << std::flush;
+    }
+}
+
+
+// Возвращает текст ошибки последнего системного вызова
+static std::string GetErrorText(std::string_view operation) {
+    return std::string(operation) + ": "s + std::strerror(errno);
+}
+
+// Создает неблокирующий слушающий Unix-сокет
+static int ListenUnixSocket(const std::string& socket_path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Wrong socket path: "s + socket_path);
+    }
+    std::memcpy(address.sun_path, socket_path.data(), socket_path.size());
+
+    const int listen_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        throw std::runtime_error(GetErrorText("socket"sv));
+    }
+    ::unlink(socket_path.c_str());
+    if (::bind(listen_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0
+            || ::listen(listen_fd, SOMAXCONN) < 0) {
+        const std::string error_text = GetErrorText("bind"sv);
+        ::close(listen_fd);
+        throw std::runtime_error(error_text);
+    }
+    return listen_fd;
+}
+
+// Создает неблокирующий слушающий TCP-сокет на 127.0.0.1
+static int ListenTcpLoopback(uint16_t port) {
+    const int listen_fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        throw std::runtime_error(GetErrorText("socket"sv));
+    }
+    const int enable = 1;
+    ::setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::bind(listen_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0
+            || ::listen(listen_fd, SOMAXCONN) < 0) {
+        const std::string error_text = GetErrorText("bind"sv);
+        ::close(listen_fd);
+        throw std::runtime_error(error_text);
+    }
+    return listen_fd;
+}
+
+
+namespace {
+
+// Сколько запросов одного подключения может обрабатываться одновременно
+// (запрос обрабатывается, пока его ответ не переложен в буфер отправки)
+constexpr size_t MAX_REQUESTS_IN_FLIGHT = 256;
+// Сколько неотправленных ответов может накопиться в буфере отправки подключения: пока клиент
+// не заберет ответы и буфер не станет меньше, новые запросы этого подключения не читаются
+constexpr size_t MAX_PENDING_OUTPUT_SIZE = 1024 * 1024;
+
+// Заголовок кадра - длина содержимого (uint32, little-endian)
+constexpr size_t FRAME_HEADER_SIZE = 4;
+constexpr uint32_t MAX_FRAME_SIZE = 64 * 1024 * 1024;
+
+// Размер порции чтения из сокета
+constexpr size_t READ_CHUNK_SIZE = 16 * 1024;
+
+// Состояние одного подключения. Меняется только потоком цикла событий
+struct Connection {
+    int fd = -1;
+    bool closed = false;
+    bool peer_closed = false;           // клиент закончил передачу, осталось отправить ответы
+
+    std::string input;                  // полученные, но еще не разобранные данные
+    size_t input_offset = 0;            // начало неразобранной части input
+    std::string output;                 // ответы, ожидающие отправки
+    size_t output_offset = 0;           // начало неотправленной части output
+
+    uint64_t next_request_index = 0;    // номер следующего запроса подключения
+    uint64_t next_response_index = 0;   // номер ответа, который нужно отправить следующим
+    std::map<uint64_t, std::string> ready_responses;  // готовые ответы, опередившие предыдущие
+
+    size_t GetRequestsInFlight() const {
+        return static_cast<size_t>(next_request_index - next_response_index);
+    }
+
+    // Можно ли читать новые запросы: не превышены пределы обрабатываемых запросов и неотправленных ответов
+    bool CanAcceptRequests() const {
+        return GetRequestsInFlight() < MAX_REQUESTS_IN_FLIGHT 
+            && output.size() - output_offset < MAX_PENDING_OUTPUT_SIZE;
+    }
+};
+
+using ConnectionPtr = std::shared_ptr<Connection>;
+
+
+/*
+Цикл событий: один поток принимает подключения, читает запросы и отправляет ответы,
+запросы обрабатываются в пуле потоков.
+Рабочий поток кладет готовый ответ в общую очередь и будит цикл через eventfd,
+цикл раскладывает ответы по подключениям и отправляет их по порядку номеров запросов
+*/
+class EventLoop {
+public:
+    EventLoop(int listen_fd, bool is_tcp, Framing framing, const MessageHandler& handler, size_t workers_count);
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    ~EventLoop();
+
+    // Обслуживает подключения, возвращает управление только при ошибке epoll
+    void Run();
+
+private:
+    // Готовый ответ рабочего потока
+    struct Completion {
+        ConnectionPtr connection;
+        uint64_t index;
+        std::string response;
+    };
+
+    int listen_fd_;
+    bool is_tcp_;
+    Framing framing_;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+    const MessageHandler& handler_;
+    std::unordered_map<int, ConnectionPtr> connections_;
+
+    std::mutex completions_mutex_;
+    std::vector<Completion> completions_;
+
+    // задачи пула обращаются к полям цикла, поэтому пул останавливается первым в деструкторе
+    std::unique_ptr<parallel::ThreadPool> workers_;
+
+    void AddToEpoll(int fd, uint32_t events);
+
+    void AcceptConnections();
+    // Читает из сокета и отправляет на обработку полностью полученные запросы
+    void ReadRequests(const ConnectionPtr& connection);
+    // Отправляет на обработку запросы из буфера, пока не достигнут предел одновременных запросов
+    void DispatchRequests(const ConnectionPtr& connection);
+    // Раскладывает готовые ответы по подключениям и отправляет их
+    void CollectResponses();
+    void WriteResponses(const ConnectionPtr& connection);
+    void CloseConnection(const ConnectionPtr& connection);
+    void CloseIfFinished(const ConnectionPtr& connection);
+};
+
+EventLoop::EventLoop(int listen_fd, bool is_tcp, Framing framing, const MessageHandler& handler, size_t workers_count)
+    : listen_fd_(listen_fd)
+    , is_tcp_(is_tcp)
+    , framing_(framing)
+    , handler_(handler)
+    , workers_(std::make_unique<parallel::ThreadPool>(std::max<size_t>(1, workers_count)))
+{
+    epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        const std::string error_text = GetErrorText("epoll"sv);
+        if (epoll_fd_ >= 0) {
+            ::close(epoll_fd_);
+        }
+        if (wake_fd_ >= 0) {
+            ::close(wake_fd_);
+        }
+        throw std::runtime_error(error_text);
+    }
+    AddToEpoll(listen_fd_, EPOLLIN | EPOLLET);
+    AddToEpoll(wake_fd_, EPOLLIN | EPOLLET);
+}
+
+EventLoop::~EventLoop() {
+    workers_.reset();
+    for (const auto& [fd, connection] : connections_) {
+        ::close(fd);
+    }
+    ::close(wake_fd_);
+    ::close(epoll_fd_);
+}
+
+void EventLoop::AddToEpoll(int fd, uint32_t events) {
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fd;
+    if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+        throw std::runtime_error(GetErrorText("epoll_ctl"sv));
+    }
+}
+
+void EventLoop::Run() {
+    std::vector<epoll_event> events(64);
+    while (true) {
+        const int events_count = ::epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), -1);
+        if (events_count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(GetErrorText("epoll_wait"sv));
+        }
+        for (int i = 0; i < events_count; ++i) {
+            const int fd = events[i].data.fd;
+            const uint32_t flags = events[i].events;
+            if (fd == listen_fd_) {
+                AcceptConnections();
+                continue;
+            }
+            if (fd == wake_fd_) {
+                uint64_t counter = 0;
+                while (::read(wake_fd_, &counter, sizeof(counter)) > 0) {
+                }
+                CollectResponses();
+                continue;
+            }
+            const auto it = connections_.find(fd);
+            if (it == connections_.end()) {
+                continue;
+            }
+            // копия указателя: подключение может быть удалено из connections_ при обработке
+            const ConnectionPtr connection = it->second;
+            if (flags & EPOLLERR) {
+                CloseConnection(connection);
+                continue;
+            }
+            if (flags & EPOLLOUT) {
+                WriteResponses(connection);
+            }
+            // после отправки ответов чтение, остановленное по пределу буфера отправки, продолжается:
+            // при edge-triggered уведомлениях о данных, уже лежащих в сокете, больше не будет
+            if (flags & (EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLHUP)) {
+                ReadRequests(connection);
+            }
+            CloseIfFinished(connection);
+        }
+    }
+}
+
+void EventLoop::AcceptConnections() {
+    // edge-triggered: принимаем все ожидающие подключения
+    while (true) {
+        const int client_fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                std::cerr << "LOG err: in EventLoop::AcceptConnections "s << GetErrorText("accept"sv) << std::endl;
+            }
+            return;
+        }
+        if (is_tcp_) {
+            // ответы короткие, их нельзя задерживать в ожидании следующих
+            const int enable = 1;
+            ::setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        }
+        auto connection = std::make_shared<Connection>();
+        connection->fd = client_fd;
+        connections_[client_fd] = connection;
+        AddToEpoll(client_fd, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET);
+        // данные могли прийти до регистрации в epoll
+        ReadRequests(connection);
+        CloseIfFinished(connection);
+    }
+}
+
+void EventLoop::ReadRequests(const ConnectionPtr& connection) {
+    char chunk[READ_CHUNK_SIZE];
+    while (!connection->closed) {
+        DispatchRequests(connection);
+        // при достижении предела чтение продолжится, когда придут ответы (см. CollectResponses)
+        // или клиент заберет отправленные (событие EPOLLOUT)
+        if (connection->peer_closed || !connection->CanAcceptRequests()) {
+            return;
+        }
+        const ssize_t received = ::recv(connection->fd, chunk, sizeof(chunk), 0);
+        if (received > 0) {
+            connection->input.append(chunk, static_cast<size_t>(received));
+        }
+        else if (received == 0) {
+            connection->peer_closed = true;
+        }
+        else if (errno == EINTR) {
+            continue;
+        }
+        else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return;
+        }
+        else {
+            CloseConnection(connection);
+        }
+    }
+}
+
+// Извлекает из буфера подключения очередную строку-запрос, nullopt - полной строки еще нет
+static std::optional<std::string> ExtractLine(Connection& connection) {
+    const std::string& input = connection.input;
+    while (connection.input_offset < input.size()) {
+        size_t line_end = input.find('\n', connection.input_offset);
+        if (line_end == input.npos) {
+            // последняя строка без перевода строки - тоже запрос
+            if (!connection.peer_closed) {
+                return std::nullopt;
+            }
+            line_end = input.size();
+        }
+        std::string line = input.substr(connection.input_offset, line_end - connection.input_offset);
+        connection.input_offset = std::min(line_end + 1, input.size());
+        if (!IsBlankLine(line)) {
+            return line;
+        }
+    }
+    return std::nullopt;
+}
+
+// Извлекает из буфера подключения очередной кадр, nullopt - кадр получен не полностью.
+// Если объявленная длина кадра больше допустимой, выбрасывает исключение invalid_argument
+static std::optional<std::string> ExtractFrame(Connection& connection) {
+    const std::string& input = connection.input;
+    if (input.size() - connection.input_offset < FRAME_HEADER_SIZE) {
+        return std::nullopt;
+    }
+    uint32_t size = 0;
+    for (size_t i = 0; i < FRAME_HEADER_SIZE; ++i) {
+        size |= static_cast<uint32_t>(static_cast<uint8_t>(input[connection.input_offset + i])) << (8 * i);
+    }
+    if (size > MAX_FRAME_SIZE) {
+        throw std::invalid_argument("Frame is too large: "s + std::to_string(size));
+    }
+    if (input.size() - connection.input_offset - FRAME_HEADER_SIZE < size) {
+        return std::nullopt;
+    }
+    std::string frame = input.substr(connection.input_offset + FRAME_HEADER_SIZE, size);
+    connection.input_offset += FRAME_HEADER_SIZE + size;
+    return frame;
+}
+
+// Дописывает ответ в буфер отправки в формате подключения
+static void AppendResponse(std::string& output, const std::string& response, Framing framing) {
+    if (framing == Framing::LINES) {
+        output += response;
+        output += '\n';
+        return;
+    }
+    const uint32_t size = static_cast<uint32_t>(response.size());
+    for (size_t i = 0; i < FRAME_HEADER_SIZE; ++i) {
+        output.push_back(static_cast<char>((size >> (8 * i)) & 0xFF));
+    }
+    output += response;
+}
+
+void EventLoop::DispatchRequests(const ConnectionPtr& connection) {
+    std::string& input = connection->input;
+    while (connection->CanAcceptRequests()) {
+        std::optional<std::string> message;
+        try {
+            message = framing_ == Framing::LINES ? ExtractLine(*connection) : ExtractFrame(*connection);
+        }
+        catch (const std::exception& e) {
+            // дальше поток данных не разобрать
+            std::cerr << "LOG err: in EventLoop::DispatchRequests: "s << e.what() << std::endl;
+            CloseConnection(connection);
+            return;
+        }
+        if (!message) {
+            break;
+        }
+
+        const uint64_t index = connection->next_request_index++;
+        workers_->Submit([this, connection, index, message = std::move(*message)]() {
+            std::string response;
+            try {
+                response = handler_(message);
+            }
+            catch (const std::exception& e) {
+                std::cerr << "LOG err: in EventLoop request handler: "s << e.what() << std::endl;
+            }
+            {
+                std::lock_guard<std::mutex> guard(completions_mutex_);
+                completions_.push_back({connection, index, std::move(response)});
+            }
+            const uint64_t one = 1;
+            [[maybe_unused]] const ssize_t written = ::write(wake_fd_, &one, sizeof(one));
+        });
+    }
+    // разобранную часть буфера удаляем, когда её набирается много
+    if (connection->input_offset == input.size()) {
+        input.clear();
+        connection->input_offset = 0;
+    }
+    else if (connection->input_offset > READ_CHUNK_SIZE) {
+        input.erase(0, connection->input_offset);
+        connection->input_offset = 0;
+    }
+}
+
+void EventLoop::CollectResponses() {
+    std::vector<Completion> completions;
+    {
+        std::lock_guard<std::mutex> guard(completions_mutex_);
+        completions.swap(completions_);
+    }
+
+    std::vector<ConnectionPtr> touched_connections;
+    for (Completion& completion : completions) {
+        Connection& connection = *completion.connection;
+        if (connection.closed) {
+            continue;
+        }
+        // отправить что-то можно, только когда пришел ответ, которого ждет подключение
+        // (номера ответов уникальны, поэтому подключение попадет в список не больше одного раза)
+        if (completion.index == connection.next_response_index) {
+            touched_connections.push_back(completion.connection);
+        }
+        connection.ready_responses.emplace(completion.index, std::move(completion.response));
+    }
+
+    for (const ConnectionPtr& connection : touched_connections) {
+        // переносим в буфер отправки ответы, идущие подряд по номерам
+        auto& ready = connection->ready_responses;
+        for (auto it = ready.begin(); it != ready.end() && it->first == connection->next_response_index; it = ready.erase(it)) {
+            AppendResponse(connection->output, it->second, framing_);
+            ++connection->next_response_index;
+        }
+        WriteResponses(connection);
+        // место для новых запросов освободилось: дочитываем то, что ждет в буфере и в сокете
+        ReadRequests(connection);
+        CloseIfFinished(connection);
+    }
+}
+
+void EventLoop::WriteResponses(const ConnectionPtr& connection) {
+    std::string& output = connection->output;
+    while (!connection->closed && connection->output_offset < output.size()) {
+        const ssize_t sent = ::send(connection->fd, output.data() + connection->output_offset,
+                                    output.size() - connection->output_offset, MSG_NOSIGNAL);
+        if (sent >= 0) {
+            connection->output_offset += static_cast<size_t>(sent);
+        }
+        else if (errno == EINTR) {
+            continue;
+        }
+        else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            // продолжим по событию EPOLLOUT, отправленную часть буфера удаляем, когда её набирается много
+            if (connection->output_offset >= MAX_PENDING_OUTPUT_SIZE) {
+                output.erase(0, connection->output_offset);
+                connection->output_offset = 0;
+            }
+            return;
+        }
+        else {
+            CloseConnection(connection);
+            return;
+        }
+    }
+    output.clear();
+    connection->output_offset = 0;
+}
+
+void EventLoop::CloseConnection(const ConnectionPtr& connection) {
+    if (connection->closed) {
+        return;
+    }
+    connection->closed = true;
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, connection->fd, nullptr);
+    ::close(connection->fd);
+    connections_.erase(connection->fd);
+}
+
+void EventLoop::CloseIfFinished(const ConnectionPtr& connection) {
+    if (connection->peer_closed && connection->GetRequestsInFlight() == 0 && connection->output.empty()) {
+        CloseConnection(connection);
+    }
+}
+
+}  // namespace
+
+
+void server::ServeConnections(const ListenAddress& address, Framing framing, const MessageHandler& handler, size_t workers_count) {
+    const bool is_tcp = address.socket_path.empty();
+    const int listen_fd = is_tcp ? ListenTcpLoopback(address.tcp_port) : ListenUnixSocket(address.socket_path);
+    try {
+        EventLoop event_loop(listen_fd, is_tcp, framing, handler, workers_count);
+        event_loop.Run();
+    }
+    catch (...) {
+        ::close(listen_fd);
+        throw;
+    }
+}
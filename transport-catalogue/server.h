@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+
+/*
+ * Режим сервера: база загружается и маршрутизатор строится один раз,
+ * после чего запросы принимаются построчно (одна строка - один JSON-запрос, NDJSON)
+ * и ответ на каждый из них выводится одной строкой сразу после обработки.
+ *
+ * Запросы принимаются из потока ввода или по сети от многих клиентов одновременно:
+ * через локальный Unix-сокет или TCP-порт на 127.0.0.1. По сети вместо JSON можно
+ * использовать двоичный протокол (binary_protocol.h) в кадрах с длиной.
+ */
+
+namespace server {
+
+// Обрабатывает один запрос (строку JSON или содержимое кадра) и возвращает ответ в том же формате
+// (без перевода строки или заголовка кадра).
+// В сетевом режиме вызывается одновременно из нескольких потоков и не должна выбрасывать исключений
+using MessageHandler = std::function<std::string(const std::string& message)>;
+
+// Как сообщения разделяются в потоке данных подключения
+enum class Framing {
+    LINES,              // одна строка - одно сообщение (NDJSON)
+    LENGTH_PREFIXED,    // кадры: длина содержимого (uint32, little-endian) и содержимое
+};
+
+// Где принимать подключения: Unix-сокет, если задан путь, иначе TCP-порт на 127.0.0.1
+struct ListenAddress {
+    std::string socket_path;
+    uint16_t tcp_port = 0;
+};
+
+// Читает запросы построчно из input и отвечает на каждый в output, пока input не закончится.
+// Пустые строки пропускаются
+void ServeStream(std::istream& input, std::ostream& output, const MessageHandler& handler);
+
+/*
+Принимает подключения по адресу address и обслуживает их одновременно.
+
+Все подключения обслуживает один поток с циклом событий epoll (неблокирующие сокеты,
+edge-triggered), а запросы обрабатывают workers_count рабочих потоков.
+Запросы одного подключения могут обрабатываться параллельно, но ответы отправляются
+в том же порядке, в котором пришли запросы. Подключение с кадром больше 64 МБ закрывается.
+Если файл Unix-сокета уже существует, он пересоздается.
+При ошибке создания сокета выбрасывает std::runtime_error
+*/
+void ServeConnections(const ListenAddress& address, Framing framing, const MessageHandler& handler, size_t workers_count);
+
+}  // namespace server
@@ -257,14 +257,26 @@ void Document::AddPtr(std::unique_ptr<Object>&& obj) {
 
 // Выводит в ostream svg-представление документа
 void Document::Render(std::ostream& out) const {
-    out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?> \n"sv; 
-    out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">\n"sv;
-    RenderContext out_context(out, 2, 2);
+    RenderBegin(out);
+    RenderContext out_context = MakeObjectsContext(out);
     for (const auto& obj_ptr : objects_) {
         obj_ptr->Render(out_context);
     }
+    RenderEnd(out);
+}
+
+void Document::RenderBegin(std::ostream& out) {
+    out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?> \n"sv; 
+    out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">\n"sv;
+}
+
+void Document::RenderEnd(std::ostream& out) {
     out << "</svg>"sv;
 }
 
+RenderContext Document::MakeObjectsContext(std::ostream& out) {
+    return RenderContext(out, 2, 2);
+}
+
 
 }  // namespace svg
\ No newline at end of file
@@ -346,6 +346,14 @@ public:
     // Выводит в ostream svg-представление документа
     void Render(std::ostream& out) const;
 
+    // Выводят начало svg-документа (до объектов) и его окончание (после объектов).
+    // Нужны, чтобы собрать документ из заранее отрисованных фрагментов
+    static void RenderBegin(std::ostream& out);
+    static void RenderEnd(std::ostream& out);
+
+    // Возвращает контекст, с которым документ выводит свои объекты
+    static RenderContext MakeObjectsContext(std::ostream& out);
+
     // Прочие методы и данные, необходимые для реализации класса Document
 
 private:
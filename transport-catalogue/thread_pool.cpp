@@ -0,0 +1,54 @@
+#include "thread_pool.h"
+
+using namespace parallel;
+
+
+ThreadPool::ThreadPool(size_t threads_count) {
+    if (threads_count == 0) {
+        threads_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers_.reserve(threads_count);
+    for (size_t i = 0; i < threads_count; ++i) {
+        workers_.emplace_back([this]() {
+            WorkerLoop();
+        });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        stopping_ = true;
+    }
+    has_task_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    has_task_.notify_one();
+}
+
+void ThreadPool::WorkerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            has_task_.wait(lock, [this]() {
+                return stopping_ || !tasks_.empty();
+            });
+            // при остановке сначала дорабатываем очередь
+            if (tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
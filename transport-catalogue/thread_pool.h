@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Пул потоков для параллельной обработки запросов.
+ *
+ * Потоки создаются один раз в конструкторе и ждут задачи в общей очереди.
+ * Submit добавляет одну задачу, ParallelFor разбивает диапазон индексов на части
+ * и ждет, пока все они будут обработаны (вызывающий поток тоже участвует в работе).
+ */
+
+namespace parallel {
+
+class ThreadPool {
+public:
+    // threads_count - число рабочих потоков, 0 - по числу ядер
+    explicit ThreadPool(size_t threads_count = 0);
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Дожидается выполнения всех задач и останавливает потоки
+    ~ThreadPool();
+
+    size_t GetThreadsCount() const {
+        return workers_.size();
+    }
+
+    // Добавляет задачу в очередь
+    void Submit(std::function<void()> task);
+
+    /*
+    Вызывает func(i) для всех i из [0, count) и возвращает управление, когда все вызовы завершены.
+    Индексы раздаются потокам порциями, порядок вызовов не определен,
+    поэтому func должна записывать результат для i в собственную ячейку.
+    Если какой-то вызов выбросил исключение, оно будет выброшено из ParallelFor
+    */
+    template <typename Func>
+    void ParallelFor(size_t count, Func func);
+
+private:
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable has_task_;
+    bool stopping_ = false;
+
+    void WorkerLoop();
+};
+
+
+template <typename Func>
+void ThreadPool::ParallelFor(size_t count, Func func) {
+    if (count == 0) {
+        return;
+    }
+    // Порции по несколько индексов: меньше обращений к общему счетчику,
+    // но достаточно мелко, чтобы потоки загружались равномерно
+    const size_t parts_count = workers_.size() + 1;
+    const size_t chunk_size = std::max<size_t>(1, count / (parts_count * 8));
+
+    std::atomic<size_t> next_index = 0;
+    std::atomic<size_t> finished_parts = 0;
+    std::mutex error_mutex;
+    std::exception_ptr error;
+
+    auto run_part = [&]() {
+        try {
+            for (size_t begin = next_index.fetch_add(chunk_size); begin < count; begin = next_index.fetch_add(chunk_size)) {
+                const size_t end = std::min(count, begin + chunk_size);
+                for (size_t i = begin; i < end; ++i) {
+                    func(i);
+                }
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> guard(error_mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+            // остальные индексы не раздаем
+            next_index = count;
+        }
+    };
+
+    std::mutex done_mutex;
+    std::condition_variable done;
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        Submit([&]() {
+            run_part();
+            std::lock_guard<std::mutex> guard(done_mutex);
+            ++finished_parts;
+            done.notify_one();
+        });
+    }
+    run_part();
+
+    std::unique_lock<std::mutex> lock(done_mutex);
+    done.wait(lock, [&]() {
+        return finished_parts == workers_.size();
+    });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+}  // namespace parallel
@@ -0,0 +1,157 @@
+/*
+ * Замер загрузки базы транспортного справочника из файла JSON двумя способами:
+ *  - document: документ строится деревом целиком (JsonReader::LoadJsonFile), после чего
+ *    запросы base_requests из дерева применяются к каталогу (ApplyCommands);
+ *  - stream: загрузка, которой пользуется программа (JsonReader::LoadJsonFileToCatalogue).
+ *
+ * Для каждого способа выводит лучшее из нескольких запусков время загрузки, число выделений памяти
+ * за одну загрузку (вместе с самим каталогом) и пиковый объем резидентной памяти. Каждый способ
+ * замеряется в отдельном процессе, чтобы пиковая память одного не влияла на другой.
+ *
+ * Сборка: g++ -std=c++17 -O2 -pthread tools/catalogue_load_bench.cpp $(ls *.cpp | grep -vx main.cpp) -o catalogue_load_bench
+ * Запуск:  catalogue_load_bench [--repeat 5] [--threads 1] FILE...
+ */
+
+#include "../json_reader.h"
+#include "../transport_catalogue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std::literals;
+using Clock = std::chrono::steady_clock;
+
+static std::atomic<size_t> allocations_count{0};
+
+void* operator new(size_t size) {
+    allocations_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+// Память выделяется malloc и освобождается free. Освобождение не встраивается: иначе GCC видит free
+// для указателя из operator new в коде контейнеров и предупреждает (-Wmismatched-new-delete)
+[[gnu::noinline]] void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+
+/*
+Загружает базу функцией load(reader, catalogue) repeat раз, каждый раз в новый каталог,
+и выводит лучшее время, число выделений памяти за загрузку и размер каталога
+*/
+template <typename Load>
+static void MeasureLoad(const std::string& name, size_t repeat, size_t threads_count, Load load) {
+    double best_seconds = 0;
+    size_t allocations = 0;
+    size_t stops_count = 0;
+    size_t buses_count = 0;
+    for (size_t i = 0; i < repeat; ++i) {
+        JsonReader reader;
+        reader.SetThreadsCount(threads_count);
+        transport::TransportCatalogue catalogue;
+
+        const size_t allocations_before = allocations_count.load(std::memory_order_relaxed);
+        const auto start = Clock::now();
+        load(reader, catalogue);
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        allocations = allocations_count.load(std::memory_order_relaxed) - allocations_before;
+
+        best_seconds = (i == 0) ? seconds : std::min(best_seconds, seconds);
+        stops_count = catalogue.GetAllStops().size();
+        buses_count = catalogue.GetAllBuses().size();
+    }
+    rusage usage{};
+    ::getrusage(RUSAGE_SELF, &usage);
+    std::cout << "  "s << std::setw(9) << std::left << name << std::right
+              << " load "s << std::setw(8) << best_seconds * 1000 << " ms, "s
+              << "allocations "s << std::setw(9) << allocations << ", "s
+              << "peak RSS "s << usage.ru_maxrss / 1024 << " MB ("s
+              << stops_count << " stops, "s << buses_count << " buses)"s << std::endl;
+}
+
+// Выполняет func в дочернем процессе и ждет его завершения
+template <typename Func>
+static void RunInChildProcess(Func func) {
+    std::cout.flush();
+    const pid_t pid = ::fork();
+    if (pid < 0) {
+        throw std::runtime_error("Can not fork"s);
+    }
+    if (pid == 0) {
+        int code = 0;
+        try {
+            func();
+        }
+        catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            code = 1;
+        }
+        std::cout.flush();
+        ::_exit(code);
+    }
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+}
+
+
+int main(int argc, char** argv) {
+    try {
+        size_t repeat = 5;
+        size_t threads_count = 1;
+        std::vector<std::string> paths;
+        for (int i = 1; i < argc; ++i) {
+            if (argv[i] == "--repeat"s && i + 1 < argc) {
+                repeat = std::max<size_t>(1, std::stoul(argv[++i]));
+            }
+            else if (argv[i] == "--threads"s && i + 1 < argc) {
+                threads_count = std::max<size_t>(1, std::stoul(argv[++i]));
+            }
+            else {
+                paths.push_back(argv[i]);
+            }
+        }
+        if (paths.empty()) {
+            throw std::invalid_argument("Usage: catalogue_load_bench [--repeat N] [--threads N] FILE..."s);
+        }
+
+        std::cout << std::fixed << std::setprecision(1);
+        for (const std::string& path : paths) {
+            std::cout << path << ":"s << std::endl;
+            RunInChildProcess([&path, repeat, threads_count]() {
+                MeasureLoad("document"s, repeat, threads_count, [&path](JsonReader& reader, transport::TransportCatalogue& catalogue) {
+                    reader.LoadJsonFile(path);
+                    reader.ApplyCommands(catalogue);
+                });
+            });
+            RunInChildProcess([&path, repeat, threads_count]() {
+                MeasureLoad("stream"s, repeat, threads_count, [&path](JsonReader& reader, transport::TransportCatalogue& catalogue) {
+                    reader.LoadJsonFileToCatalogue(path, catalogue);
+                });
+            });
+        }
+        return 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
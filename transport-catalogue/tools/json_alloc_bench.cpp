@@ -0,0 +1,141 @@
+/*
+ * Сравнение разбора JSON в дерево json::Document (каждый узел, строка и ключ - отдельный блок
+ * из кучи) и в документ-представление json::ViewDocument (узлы и строки с экранированием - в арене
+ * документа, остальные строки - во входном буфере).
+ *
+ * Для каждого файла и каждого способа выводит лучшее из нескольких запусков время разбора
+ * и время уничтожения документа, а также пиковый объем резидентной памяти. Каждый способ
+ * замеряется в отдельном процессе, чтобы пиковая память одного не влияла на другой.
+ *
+ * Сборка: g++ -std=c++17 -O2 tools/json_alloc_bench.cpp json_scanner.cpp json.cpp -o json_alloc_bench
+ * Запуск:  json_alloc_bench [--repeat 10] FILE...
+ */
+
+#include "../json.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std::literals;
+using Clock = std::chrono::steady_clock;
+
+
+static std::string ReadFile(const std::string& path) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        throw std::runtime_error("Can not open "s + path);
+    }
+    std::ostringstream content;
+    content << input.rdbuf();
+    return content.str();
+}
+
+static double SecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/*
+Замеряет разбор буфера функцией load и уничтожение полученного документа.
+load получает копию буфера (копирование в замер не входит)
+*/
+template <typename Load>
+static void MeasureDocument(const std::string& name, const std::string& text, size_t repeat, Load load) {
+    double best_parse = 0;
+    double best_destroy = 0;
+    for (size_t i = 0; i < repeat; ++i) {
+        std::string buffer = text;
+        auto start = Clock::now();
+        std::optional document(load(std::move(buffer)));
+        const double parse_seconds = SecondsSince(start);
+
+        start = Clock::now();
+        document.reset();
+        const double destroy_seconds = SecondsSince(start);
+
+        best_parse = (i == 0) ? parse_seconds : std::min(best_parse, parse_seconds);
+        best_destroy = (i == 0) ? destroy_seconds : std::min(best_destroy, destroy_seconds);
+    }
+    rusage usage{};
+    ::getrusage(RUSAGE_SELF, &usage);
+    std::cout << "  "s << std::setw(14) << std::left << name << std::right
+              << " parse "s << std::setw(8) << best_parse * 1000 << " ms, "s
+              << "destroy "s << std::setw(8) << best_destroy * 1000 << " ms, "s
+              << "peak RSS "s << usage.ru_maxrss / 1024 << " MB"s << std::endl;
+}
+
+// Выполняет func в дочернем процессе и ждет его завершения
+template <typename Func>
+static void RunInChildProcess(Func func) {
+    std::cout.flush();
+    const pid_t pid = ::fork();
+    if (pid < 0) {
+        throw std::runtime_error("Can not fork"s);
+    }
+    if (pid == 0) {
+        int code = 0;
+        try {
+            func();
+        }
+        catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            code = 1;
+        }
+        std::cout.flush();
+        ::_exit(code);
+    }
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+}
+
+
+int main(int argc, char** argv) {
+    try {
+        size_t repeat = 10;
+        std::vector<std::string> paths;
+        for (int i = 1; i < argc; ++i) {
+            if (argv[i] == "--repeat"s && i + 1 < argc) {
+                repeat = std::max<size_t>(1, std::stoul(argv[++i]));
+            }
+            else {
+                paths.push_back(argv[i]);
+            }
+        }
+        if (paths.empty()) {
+            throw std::invalid_argument("Usage: json_alloc_bench [--repeat N] FILE..."s);
+        }
+
+        std::cout << std::fixed << std::setprecision(2);
+        for (const std::string& path : paths) {
+            std::cout << path << ":"s << std::endl;
+            RunInChildProcess([&path, repeat]() {
+                const std::string text = ReadFile(path);
+                MeasureDocument("json::Load"s, text, repeat, [](std::string buffer) {
+                    return json::Load(std::string_view(buffer));
+                });
+            });
+            RunInChildProcess([&path, repeat]() {
+                const std::string text = ReadFile(path);
+                MeasureDocument("json::LoadView"s, text, repeat, [](std::string buffer) {
+                    return json::LoadView(std::move(buffer));
+                });
+            });
+        }
+        return 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,206 @@
+/*
+ * Замер построения ответов на запросы stat_requests через json::Builder так же, как их строит
+ * json_reader.cpp: ответ на Stop (массив названий автобусов), Bus (словарь из пяти ключей)
+ * и Route (массив словарей-шагов маршрута).
+ *
+ * Для каждого вида ответа выводит время построения и число выделений памяти на один ответ,
+ * а рядом - сколько блоков памяти занимает сам построенный ответ (непустые массивы и словари
+ * и строки, не поместившиеся во встроенный буфер std::string). Кроме этих блоков каждый
+ * Builder выделяет один блок под стек открытых узлов (в ответе на Route строителей девять:
+ * по одному на шаг и один на весь ответ). Все остальное - лишние перевыделения или глубокие копии.
+ *
+ * Сборка: g++ -std=c++17 -O2 tools/json_builder_bench.cpp json_builder.cpp json.cpp json_scanner.cpp -o json_builder_bench
+ * Запуск:  json_builder_bench [--repeat 100000]
+ */
+
+#include "../json.h"
+#include "../json_builder.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std::literals;
+using Clock = std::chrono::steady_clock;
+
+static std::atomic<size_t> allocations_count{0};
+
+void* operator new(size_t size) {
+    allocations_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+// Память выделяется malloc и освобождается free. Освобождение не встраивается: иначе GCC видит free
+// для указателя из operator new в коде контейнеров и предупреждает (-Wmismatched-new-delete)
+[[gnu::noinline]] void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+
+// Сколько блоков из кучи занимает дерево node
+static size_t CountHeapBlocks(const json::Node& node) {
+    const std::string empty_string;
+    size_t count = 0;
+    if (node.IsArray()) {
+        count += node.AsArray().empty() ? 0 : 1;
+        for (const json::Node& item : node.AsArray()) {
+            count += CountHeapBlocks(item);
+        }
+    }
+    else if (node.IsDict()) {
+        count += node.AsDict().empty() ? 0 : 1;
+        for (const auto& [key, value] : node.AsDict()) {
+            count += key.size() > empty_string.capacity() ? 1 : 0;
+            count += CountHeapBlocks(value);
+        }
+    }
+    else if (node.IsString()) {
+        count += node.AsString().size() > empty_string.capacity() ? 1 : 0;
+    }
+    return count;
+}
+
+
+// Ответ на запрос Stop: названия автобусов приходят из каталога как string_view
+static json::Dict BuildStopResponse(int id, const std::vector<std::string_view>& buses) {
+    json::Array buses_array;
+    buses_array.reserve(buses.size());
+    for (std::string_view bus_name : buses) {
+        buses_array.emplace_back(std::string(bus_name));
+    }
+    return json::Builder{}
+                .StartDict()
+                    .Key("request_id"s).Value(id)
+                    .Key("buses"s).Value(std::move(buses_array))
+                .EndDict()
+                .Build()
+                .AsDict();
+}
+
+static json::Dict BuildBusResponse(int id) {
+    return json::Builder{}
+                .StartDict()
+                    .Key("request_id"s).Value(id)
+                    .Key("route_length"s).Value(27400.0)
+                    .Key("curvature"s).Value(1.23199)
+                    .Key("stop_count"s).Value(5)
+                    .Key("unique_stop_count"s).Value(3)
+                .EndDict()
+                .Build()
+                .AsDict();
+}
+
+struct RouteStep {
+    std::string stop;
+    std::string bus;
+    double wait_time;
+    double bus_time;
+    int span_count;
+};
+
+static json::Dict BuildRouteResponse(int id, const std::vector<RouteStep>& steps) {
+    json::Array items;
+    items.reserve(steps.size() * 2);
+    double total_time = 0;
+    for (const RouteStep& step : steps) {
+        items.emplace_back(json::Builder{}.StartDict()
+                                              .Key("type"s).Value("Wait"s)
+                                              .Key("time"s).Value(step.wait_time)
+                                              .Key("stop_name"s).Value(step.stop)
+                                          .EndDict()
+                                          .Build());
+        items.emplace_back(json::Builder{}.StartDict()
+                                              .Key("type"s).Value("Bus"s)
+                                              .Key("time"s).Value(step.bus_time)
+                                              .Key("bus"s).Value(step.bus)
+                                              .Key("span_count"s).Value(step.span_count)
+                                          .EndDict()
+                                          .Build());
+        total_time += step.wait_time + step.bus_time;
+    }
+    return json::Builder{}
+                .StartDict()
+                    .Key("request_id"s).Value(id)
+                    .Key("total_time"s).Value(total_time)
+                    .Key("items"s).Value(std::move(items))
+                .EndDict()
+                .Build()
+                .AsDict();
+}
+
+
+// Строит ответ функцией build repeat раз и выводит время и число выделений памяти на один ответ
+template <typename Build>
+static void Measure(const std::string& name, size_t repeat, Build build) {
+    const size_t blocks = CountHeapBlocks(json::Node(build()));
+
+    size_t checksum = 0;
+    const size_t allocations_before = allocations_count.load(std::memory_order_relaxed);
+    const auto start = Clock::now();
+    for (size_t i = 0; i < repeat; ++i) {
+        checksum += build().size();
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    const size_t allocations = allocations_count.load(std::memory_order_relaxed) - allocations_before;
+
+    std::cout << "  "s << std::setw(22) << std::left << name << std::right
+              << std::setw(8) << seconds * 1e9 / repeat << " ns, "s
+              << "allocations "s << std::setw(6) << static_cast<double>(allocations) / repeat
+              << ", blocks in response "s << blocks
+              << (checksum == 0 ? " (empty)"s : ""s) << std::endl;
+}
+
+
+int main(int argc, char** argv) {
+    try {
+        size_t repeat = 100000;
+        for (int i = 1; i < argc; ++i) {
+            if (argv[i] == "--repeat"s && i + 1 < argc) {
+                repeat = std::max<size_t>(1, std::stoul(argv[++i]));
+            }
+            else {
+                throw std::invalid_argument("Usage: json_builder_bench [--repeat N]"s);
+            }
+        }
+
+        const std::vector<std::string> bus_names = {"14"s, "22к"s, "Airport Express Line"s, "256"s, "828"s,
+                                                    "Night Shuttle Route N1"s, "750"s, "11"s};
+        const std::vector<std::string_view> buses(bus_names.begin(), bus_names.end());
+
+        std::vector<RouteStep> steps;
+        for (int i = 0; i < 4; ++i) {
+            steps.push_back({"Улица Лизы Чайкиной "s + std::to_string(i), bus_names[i], 6, 11.235, i + 1});
+        }
+
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "json::Builder, "s << repeat << " responses of each kind:"s << std::endl;
+        Measure("Stop (8 buses)"s, repeat, [&buses]() {
+            return BuildStopResponse(1, buses);
+        });
+        Measure("Bus"s, repeat, []() {
+            return BuildBusResponse(2);
+        });
+        Measure("Route (8 items)"s, repeat, [&steps]() {
+            return BuildRouteResponse(3, steps);
+        });
+        return 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,115 @@
+/*
+ * Замер скорости поиска структурных позиций JSON (json_scanner.h) на входных файлах справочника.
+ *
+ * Для каждого файла и каждой доступной реализации (scalar, sse2, avx2) несколько раз проходит
+ * файл сканером структурных позиций и выводит лучшую скорость в ГБ/с, а также скорость полного
+ * разбора json::Load, который использует сканер, и разбора в документ-представление json::LoadView.
+ *
+ * Сборка: g++ -std=c++17 -O2 tools/json_scan_bench.cpp json_scanner.cpp json.cpp -o json_scan_bench
+ * Запуск:  json_scan_bench [--repeat 20] FILE...
+ */
+
+#include "../json.h"
+#include "../json_scanner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std::literals;
+using Clock = std::chrono::steady_clock;
+
+
+static std::string ReadFile(const std::string& path) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        throw std::runtime_error("Can not open "s + path);
+    }
+    std::ostringstream content;
+    content << input.rdbuf();
+    return content.str();
+}
+
+// Возвращает лучшее время из repeat запусков func в секундах
+template <typename Func>
+static double MeasureBest(size_t repeat, Func func) {
+    double best = 0;
+    for (size_t i = 0; i < repeat; ++i) {
+        const auto start = Clock::now();
+        func();
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        best = (i == 0) ? seconds : std::min(best, seconds);
+    }
+    return best;
+}
+
+
+int main(int argc, char** argv) {
+    try {
+        size_t repeat = 20;
+        std::vector<std::string> paths;
+        for (int i = 1; i < argc; ++i) {
+            if (argv[i] == "--repeat"s && i + 1 < argc) {
+                repeat = std::max<size_t>(1, std::stoul(argv[++i]));
+            }
+            else {
+                paths.push_back(argv[i]);
+            }
+        }
+        if (paths.empty()) {
+            throw std::invalid_argument("Usage: json_scan_bench [--repeat N] FILE..."s);
+        }
+
+        const json_scan::Level best_level = json_scan::GetBestLevel();
+        std::cout << std::fixed << std::setprecision(2);
+        for (const std::string& path : paths) {
+            const std::string text = ReadFile(path);
+            const double gigabytes = static_cast<double>(text.size()) / 1e9;
+            std::cout << path << ": "s << text.size() << " bytes\n"s;
+
+            for (json_scan::Level level : {json_scan::Level::SCALAR, json_scan::Level::SSE2, json_scan::Level::AVX2}) {
+                if (static_cast<int>(level) > static_cast<int>(best_level)) {
+                    continue;
+                }
+                size_t indices_count = 0;
+                const double seconds = MeasureBest(repeat, [&]() {
+                    json_scan::StructuralScanner scanner(text, level);
+                    indices_count = 0;
+                    while (scanner.ScanNextChunk()) {
+                        indices_count += static_cast<size_t>(scanner.end() - scanner.begin());
+                    }
+                });
+                std::cout << "  stage 1 "s << std::setw(6) << json_scan::GetLevelName(level) << ": "s
+                          << gigabytes / seconds << " GB/s, "s << indices_count << " indices\n"s;
+            }
+
+            const double load_seconds = MeasureBest(repeat, [&]() {
+                json::Load(std::string_view(text));
+            });
+            std::cout << "  json::Load: "s << gigabytes * 1000 / load_seconds << " MB/s"s << std::endl;
+
+            // копия буфера, который забирает документ, в замер не входит
+            std::string buffer;
+            double view_seconds = 0;
+            for (size_t i = 0; i < repeat; ++i) {
+                buffer = text;
+                const double seconds = MeasureBest(1, [&]() {
+                    json::LoadView(std::move(buffer));
+                });
+                view_seconds = (i == 0) ? seconds : std::min(view_seconds, seconds);
+            }
+            std::cout << "  json::LoadView: "s << gigabytes * 1000 / view_seconds << " MB/s"s << std::endl;
+        }
+        return 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,279 @@
+/*
+ * Генератор нагрузки для режима сервера (--serve --socket PATH или --serve --port N).
+ *
+ * Открывает несколько подключений, в каждом по кругу отправляет запросы из файла NDJSON
+ * (одна строка - один запрос stat_request), держа в полете до pipeline запросов,
+ * и измеряет время от отправки запроса до получения ответа на него.
+ * Проверяет, что ответы приходят в порядке запросов (по request_id).
+ * В конце выводит пропускную способность и перцентили задержки.
+ *
+ * Сборка: g++ -std=c++17 -O2 -pthread tools/load_client.cpp -o load_client
+ * Запуск:  load_client (--socket PATH | --port N) --requests FILE
+ *                      [--connections 4] [--count 10000] [--pipeline 1]
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std::literals;
+using Clock = std::chrono::steady_clock;
+
+
+struct Options {
+    std::string socket_path;
+    uint16_t tcp_port = 0;
+    std::string requests_path;
+    size_t connections = 4;
+    size_t count = 10000;      // запросов на одно подключение
+    size_t pipeline = 1;       // запросов в полете на одно подключение
+};
+
+// Результат одного подключения
+struct ConnectionStats {
+    std::vector<double> latencies_us;
+    size_t order_errors = 0;
+    std::string error;
+};
+
+
+static Options ParseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string name = argv[i];
+        const std::string value = argv[i + 1];
+        if (name == "--socket"s) {
+            options.socket_path = value;
+        }
+        else if (name == "--port"s) {
+            options.tcp_port = static_cast<uint16_t>(std::stoul(value));
+        }
+        else if (name == "--requests"s) {
+            options.requests_path = value;
+        }
+        else if (name == "--connections"s) {
+            options.connections = std::max<size_t>(1, std::stoul(value));
+        }
+        else if (name == "--count"s) {
+            options.count = std::stoul(value);
+        }
+        else if (name == "--pipeline"s) {
+            options.pipeline = std::max<size_t>(1, std::stoul(value));
+        }
+        else {
+            throw std::invalid_argument("Unknown option "s + name);
+        }
+    }
+    if (options.requests_path.empty() || (options.socket_path.empty() && options.tcp_port == 0)) {
+        throw std::invalid_argument("Usage: load_client (--socket PATH | --port N) --requests FILE "
+                                    "[--connections C] [--count N] [--pipeline D]"s);
+    }
+    return options;
+}
+
+static std::vector<std::string> ReadRequests(const std::string& path) {
+    std::ifstream input(path);
+    if (!input) {
+        throw std::runtime_error("Can not open "s + path);
+    }
+    std::vector<std::string> requests;
+    std::string line;
+    while (std::getline(input, line)) {
+        if (line.find_first_not_of(" \t\r"sv) != line.npos) {
+            requests.push_back(line + '\n');
+        }
+    }
+    if (requests.empty()) {
+        throw std::runtime_error("No requests in "s + path);
+    }
+    return requests;
+}
+
+// Возвращает целое число, записанное после ключа key ("id" или "request_id")
+static std::optional<long long> FindIntAfterKey(std::string_view text, std::string_view key) {
+    const size_t key_pos = text.find(key);
+    if (key_pos == text.npos) {
+        return std::nullopt;
+    }
+    size_t pos = text.find(':', key_pos + key.size());
+    if (pos == text.npos) {
+        return std::nullopt;
+    }
+    pos = text.find_first_not_of(" \t"sv, pos + 1);
+    if (pos == text.npos || !(text[pos] == '-' || std::isdigit(static_cast<unsigned char>(text[pos])))) {
+        return std::nullopt;
+    }
+    return std::stoll(std::string(text.substr(pos, 24)));
+}
+
+static int Connect(const Options& options) {
+    int fd = -1;
+    if (!options.socket_path.empty()) {
+        fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, options.socket_path.c_str(), sizeof(address.sun_path) - 1);
+        if (fd < 0 || ::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0) {
+            throw std::runtime_error("connect: "s + std::strerror(errno));
+        }
+    }
+    else {
+        fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(options.tcp_port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (fd < 0 || ::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0) {
+            throw std::runtime_error("connect: "s + std::strerror(errno));
+        }
+        const int enable = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    }
+    return fd;
+}
+
+static void SendAll(int fd, std::string_view data) {
+    while (!data.empty()) {
+        const ssize_t sent = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("send: "s + std::strerror(errno));
+        }
+        data.remove_prefix(static_cast<size_t>(sent));
+    }
+}
+
+// Отправляет count запросов по одному подключению, держа в полете до pipeline запросов
+static void RunConnection(const Options& options, const std::vector<std::string>& requests, size_t first_request, ConnectionStats& stats) {
+    const int fd = Connect(options);
+    // время отправки и ожидаемый request_id запросов, ответы на которые еще не пришли
+    std::deque<std::pair<Clock::time_point, std::optional<long long>>> in_flight;
+    std::string buffer;
+    char chunk[16 * 1024];
+    size_t sent = 0;
+    size_t received = 0;
+    stats.latencies_us.reserve(options.count);
+
+    while (received < options.count) {
+        // дополняем окно запросами одной пачкой
+        std::string batch;
+        while (sent < options.count && in_flight.size() < options.pipeline) {
+            const std::string& request = requests[(first_request + sent) % requests.size()];
+            batch += request;
+            in_flight.emplace_back(Clock::now(), FindIntAfterKey(request, "\"id\""sv));
+            ++sent;
+        }
+        if (!batch.empty()) {
+            SendAll(fd, batch);
+        }
+
+        const ssize_t read_bytes = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (read_bytes <= 0) {
+            if (read_bytes < 0 && errno == EINTR) {
+                continue;
+            }
+            ::close(fd);
+            throw std::runtime_error("Connection closed by server"s);
+        }
+        buffer.append(chunk, static_cast<size_t>(read_bytes));
+
+        size_t line_begin = 0;
+        for (size_t line_end = buffer.find('\n'); line_end != buffer.npos; line_end = buffer.find('\n', line_begin)) {
+            const auto now = Clock::now();
+            const auto [sent_time, expected_id] = in_flight.front();
+            in_flight.pop_front();
+            stats.latencies_us.push_back(std::chrono::duration<double, std::micro>(now - sent_time).count());
+
+            const std::string_view response(buffer.data() + line_begin, line_end - line_begin);
+            const std::optional<long long> response_id = FindIntAfterKey(response, "\"request_id\""sv);
+            if (expected_id && response_id && *expected_id != *response_id) {
+                ++stats.order_errors;
+            }
+            ++received;
+            line_begin = line_end + 1;
+        }
+        buffer.erase(0, line_begin);
+    }
+    ::close(fd);
+}
+
+static double GetPercentile(const std::vector<double>& sorted_values, double percent) {
+    if (sorted_values.empty()) {
+        return 0;
+    }
+    const size_t index = std::min(sorted_values.size() - 1, static_cast<size_t>(percent / 100 * sorted_values.size()));
+    return sorted_values[index];
+}
+
+
+int main(int argc, char** argv) {
+    try {
+        const Options options = ParseOptions(argc, argv);
+        const std::vector<std::string> requests = ReadRequests(options.requests_path);
+
+        std::vector<ConnectionStats> stats(options.connections);
+        std::vector<std::thread> threads;
+        const auto start = Clock::now();
+        for (size_t i = 0; i < options.connections; ++i) {
+            threads.emplace_back([&, i]() {
+                try {
+                    // подключения начинают с разных запросов, чтобы не отправлять одно и то же одновременно
+                    RunConnection(options, requests, i * requests.size() / options.connections, stats[i]);
+                }
+                catch (const std::exception& e) {
+                    stats[i].error = e.what();
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::vector<double> latencies;
+        size_t order_errors = 0;
+        for (const ConnectionStats& connection_stats : stats) {
+            if (!connection_stats.error.empty()) {
+                std::cerr << "error: "s << connection_stats.error << std::endl;
+            }
+            latencies.insert(latencies.end(), connection_stats.latencies_us.begin(), connection_stats.latencies_us.end());
+            order_errors += connection_stats.order_errors;
+        }
+        std::sort(latencies.begin(), latencies.end());
+
+        std::cout << "connections: "s << options.connections << ", pipeline: "s << options.pipeline << '\n'
+                  << "requests: "s << latencies.size() << " in "s << seconds << " s, "s
+                  << static_cast<size_t>(latencies.size() / seconds) << " req/s\n"s
+                  << "latency us: p50 "s << GetPercentile(latencies, 50)
+                  << ", p90 "s << GetPercentile(latencies, 90)
+                  << ", p99 "s << GetPercentile(latencies, 99)
+                  << ", p99.9 "s << GetPercentile(latencies, 99.9)
+                  << ", max "s << (latencies.empty() ? 0 : latencies.back()) << '\n'
+                  << "out of order responses: "s << order_errors << std::endl;
+        return order_errors == 0 ? 0 : 1;
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
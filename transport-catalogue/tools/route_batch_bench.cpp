@@ -0,0 +1,146 @@
+/*
+ * Замер ответов на группу запросов маршрутов (TransportRouter::GetRoutesInfo) в двух режимах маршрутизатора:
+ *  - ALL_PAIRS: при создании считаются пути между всеми парами вершин, запросы читают строки таблицы;
+ *  - SINGLE_SOURCE: таблицы нет, для каждой различной остановки отправления - один поиск путей.
+ *
+ * База и параметры маршрутов берутся из файла JSON, запросы - случайные пары остановок,
+ * у которых остановка отправления выбирается из origins случайных остановок.
+ * Для каждого режима выводит время создания маршрутизатора и время ответов на все запросы,
+ * а также число найденных маршрутов (оно должно совпадать в обоих режимах).
+ *
+ * Сборка: g++ -std=c++17 -O2 -pthread tools/route_batch_bench.cpp $(ls *.cpp | grep -vx main.cpp) -o route_batch_bench
+ * Запуск:  route_batch_bench [--pairs 200000] [--origins 60] FILE
+ */
+
+#include "../json.h"
+#include "../json_reader.h"
+#include "../router.h"
+#include "../transport_catalogue.h"
+#include "../transport_router.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std::literals;
+using Clock = std::chrono::steady_clock;
+
+static double GetSecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Параметры маршрутов из раздела routing_settings файла
+static routing::RoutingSettings ReadRoutingSettings(const std::string& path) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        throw std::invalid_argument("Can not open "s + path);
+    }
+    const json::Document document = json::Load(std::string_view(json::ReadAll(input)));
+    routing::RoutingSettings settings;
+    const json::Dict& root = document.GetRoot().AsDict();
+    const auto it = root.find("routing_settings"sv);
+    if (it != root.end()) {
+        const json::Dict& settings_map = it->second.AsDict();
+        if (settings_map.count("bus_wait_time"sv)) {
+            settings.bus_wait_time = settings_map.at("bus_wait_time"sv).AsInt();
+        }
+        if (settings_map.count("bus_velocity"sv)) {
+            settings.bus_velocity = settings_map.at("bus_velocity"sv).AsDouble();
+        }
+    }
+    return settings;
+}
+
+// Случайные пары остановок, остановки отправления выбираются из origins_count остановок
+static std::vector<routing::RouteQuery> MakeQueries(const std::vector<const domain::Stop*>& stops,
+                                                    size_t pairs_count, size_t origins_count) {
+    std::mt19937 generator(42);
+    std::vector<std::string_view> origins;
+    std::uniform_int_distribution<size_t> stop_distribution(0, stops.size() - 1);
+    for (size_t i = 0; i < origins_count; ++i) {
+        origins.push_back(stops[stop_distribution(generator)]->name);
+    }
+    std::uniform_int_distribution<size_t> origin_distribution(0, origins.size() - 1);
+    std::vector<routing::RouteQuery> queries;
+    queries.reserve(pairs_count);
+    for (size_t i = 0; i < pairs_count; ++i) {
+        queries.emplace_back(origins[origin_distribution(generator)], stops[stop_distribution(generator)]->name);
+    }
+    return queries;
+}
+
+static void Measure(const std::string& name, graph::RouterMode mode, const transport::TransportCatalogue& catalogue,
+                    const routing::RoutingSettings& settings, const std::vector<routing::RouteQuery>& queries) {
+    routing::TransportGraphMaker graph_maker(catalogue, settings);
+    const size_t vertex_count = graph_maker.GetGraph().GetVertexCount();
+    const size_t edge_count = graph_maker.GetGraph().GetEdgeCount();
+
+    const auto build_start = Clock::now();
+    const routing::TransportRouter router(std::move(graph_maker), mode);
+    const double build_seconds = GetSecondsSince(build_start);
+
+    const auto queries_start = Clock::now();
+    const std::vector<routing::TransportRouteInfo> routes = router.GetRoutesInfo(queries);
+    const double queries_seconds = GetSecondsSince(queries_start);
+
+    const size_t found_count = std::count_if(routes.begin(), routes.end(), [](const routing::TransportRouteInfo& route) {
+        return route.has_value();
+    });
+    std::cout << "  "s << std::setw(13) << std::left << name << std::right
+              << " build "s << std::setw(8) << build_seconds * 1000 << " ms, "s
+              << "queries "s << std::setw(8) << queries_seconds * 1000 << " ms, "s
+              << "total "s << std::setw(8) << (build_seconds + queries_seconds) * 1000 << " ms ("s
+              << vertex_count << " vertices, "s << edge_count << " edges, "s
+              << found_count << " routes found)"s << std::endl;
+}
+
+int main(int argc, char** argv) {
+    try {
+        size_t pairs_count = 200000;
+        size_t origins_count = 60;
+        std::string path;
+        for (int i = 1; i < argc; ++i) {
+            if (argv[i] == "--pairs"s && i + 1 < argc) {
+                pairs_count = std::stoul(argv[++i]);
+            }
+            else if (argv[i] == "--origins"s && i + 1 < argc) {
+                origins_count = std::max<size_t>(1, std::stoul(argv[++i]));
+            }
+            else {
+                path = argv[i];
+            }
+        }
+        if (path.empty()) {
+            throw std::invalid_argument("Usage: route_batch_bench [--pairs N] [--origins N] FILE"s);
+        }
+
+        transport::TransportCatalogue catalogue;
+        JsonReader reader;
+        reader.SetThreadsCount(1);
+        reader.LoadJsonFileToCatalogue(path, catalogue);
+        const routing::RoutingSettings settings = ReadRoutingSettings(path);
+
+        const std::vector<const domain::Stop*> stops = catalogue.GetAllStopsBusPassingThrough();
+        if (stops.empty()) {
+            throw std::invalid_argument("No stops with buses in "s + path);
+        }
+        const std::vector<routing::RouteQuery> queries = MakeQueries(stops, pairs_count, origins_count);
+
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << path << ": "s << queries.size() << " queries from "s << origins_count << " origins"s << std::endl;
+        Measure("ALL_PAIRS"s, graph::RouterMode::ALL_PAIRS, catalogue, settings, queries);
+        Measure("SINGLE_SOURCE"s, graph::RouterMode::SINGLE_SOURCE, catalogue, settings, queries);
+        return 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -1,8 +1,10 @@
 #include "transport_catalogue.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <iostream>
+#include <mutex>
 #include <numeric>
 
 using namespace std::literals; 
@@ -92,17 +94,11 @@ struct TransportCatalogue::Impl {
             return;
         }
         
-        // формируем пары остановок: forward для A->B и reverse для B->A
+        // Храним расстояние только в заданном направлении (A->B). 
+        // Обратное направление (B->A), если оно не задано явно, берется отсюда же при поиске,
+        // поэтому исправление расстояния A->B сразу действует и на B->A
         const StopsPair stop_pair_forward = std::make_pair(stopA, stopB);
-        const StopsPair stop_pair_reverse = std::make_pair(stopB, stopA);
-        
-        // Добавляем расстояние в прямом направлении (A->B)
         distances_[stop_pair_forward] = distance;
-
-        // Добавляем расстояние в обратном направлении (B->A), если оно ещё не указано
-        if (!distances_.count(stop_pair_reverse)) {
-            distances_.insert({stop_pair_reverse, distance});
-        }
     }
 
 
@@ -121,6 +117,32 @@ struct TransportCatalogue::Impl {
         }
 
         SetDistanceBetweenStops(stopA_ptr, stopB_ptr, distance);
+
+        // Пересчитываем то, что зависит от расстояния: статистику затронутых маршрутов
+        std::vector<const Bus*> touched_buses = FindBusesDrivingBetween(stopA_ptr, stopB_ptr);
+        InvalidateBusStats(touched_buses);
+        Notify({CatalogueChange::Type::DISTANCE_CHANGED, {stopA_ptr, stopB_ptr}, std::move(touched_buses)});
+    }
+
+
+    // Меняет расстояние между существующими остановками, 
+    // если остановки не существует, выбросит исключение invalid_argument
+    void UpdateDistance(std::string_view stopA_name, std::string_view stopB_name, int distance) {
+        if (!FindStop(stopA_name) || !FindStop(stopB_name)) {
+            throw std::invalid_argument("Unknown stops' names"s);
+        }
+        SetDistanceBetweenStops(stopA_name, stopB_name, distance);
+    }
+
+
+    // Меняет координаты существующей остановки, 
+    // если остановки не существует, выбросит исключение invalid_argument
+    void UpdateStop(std::string_view stop_name, geo::Coordinates coordinates) {
+        Stop* stop_ptr = const_cast<Stop*>(FindStop(stop_name));
+        if (!stop_ptr) {
+            throw std::invalid_argument("Unknown stop's name"s);
+        }
+        MoveStop(stop_ptr, coordinates);
     }
    
 
@@ -131,9 +153,11 @@ struct TransportCatalogue::Impl {
         Stop* stop_ptr = const_cast<Stop*>(FindStop(new_stop.name));
         if (stop_ptr) {
             // дополняем инфу об остановке
-            stop_ptr->coordinates = std::move(new_stop.coordinates);
+            MoveStop(stop_ptr, new_stop.coordinates);
         }
         else {
+            // id остановки - её порядковый номер в деке всех остановок
+            new_stop.id = static_cast<StopId>(stops_.size());
             // добавляем остановку в контейнер (дек) всех остановок
             stops_.push_back(std::move(new_stop));
             // указатель на добавленную остановку помещаем в словарь 
@@ -143,7 +167,7 @@ struct TransportCatalogue::Impl {
             stops_dictionary_[added_stop_name] = added_stop_ptr;
             
             // добавляем остановку в список остановок с автобусами (список пуст, будет заполняться по мере добавления автобусов)
-            busses_at_stop_[added_stop_name] = {};
+            busses_at_stop_.emplace_back();
         }
     }
 
@@ -164,49 +188,42 @@ struct TransportCatalogue::Impl {
     }
 
 
+    // Добавляет автобус, остановки маршрута задаются их id
     void AddBus(Bus new_bus) {
+        // id маршрута - его порядковый номер в деке всех маршрутов
+        new_bus.id = static_cast<BusId>(buses_.size());
         // добавляем автобус в контекнер (дек) с автобусами
         buses_.push_back(std::move(new_bus));
+        // и пустую (еще не посчитанную) статистику по нему
+        bus_stats_.emplace_back();
+        buses_removed_.push_back(false);
         // в словарь автобусов помещаем добавленный автобус, 
         // при этом ключ - это назваие маршрута (= автобуса = его номер)
         Bus* added_bus_ptr = &buses_.back();
         std::string_view added_bus_name = added_bus_ptr->name;
-        buses_dictionary_[added_bus_name] = added_bus_ptr;
+        Bus*& dictionary_bus_ptr = buses_dictionary_[added_bus_name];
+        // маршрут с тем же названием заменяется новым и по id больше не находится,
+        // а на его остановках вместо него числится новый маршрут
+        if (dictionary_bus_ptr) {
+            buses_removed_[dictionary_bus_ptr->id] = true;
+            ReplaceBusAtStops(dictionary_bus_ptr, added_bus_ptr);
+        }
+        dictionary_bus_ptr = added_bus_ptr;
         
         // добавляем автобус на остановку (в список автобусов по каждой остановке)
-        for (auto stop_tmp : added_bus_ptr->unique_stops) {
-            busses_at_stop_[stop_tmp].push_back(added_bus_name);
-        }
+        AttachBusToStops(added_bus_ptr);
+
+        Notify({CatalogueChange::Type::BUS_ADDED, {}, {added_bus_ptr}});
     }
 
 
+    // Добавляет автобус по названиям остановок. 
+    // Для некольцевого маршрута передаются остановки только прямого хода (до конечной)
     void AddBus(std::string_view bus_name, const std::vector<std::string_view>& stops_names, bool round_flag) {
-        // сюда будем записывать набор уникальных остановок
-        std::unordered_set<std::string_view> unique_stops;
-        // а здесь собирать указатели на найденные остановки 
-        std::vector<const transport::Stop*> stops_on_route;
-        
-        for (std::string_view stop_name_cur : stops_names) {
-            // ищем остановку в справочнике
-            const transport::Stop* stop_cur = FindStop(stop_name_cur);
-            // если нашлась, то добавляем в список остановок по автобусу
-            if (stop_cur) { //было ->name.empty();
-                // добавляем в список остановок, через которые проходят автобусы
-                stops_with_buses_going_through_them_.insert(stop_cur);
-                // добавляем название остановки в перечень уникальных
-                unique_stops.insert(stop_cur->name);
-                // перемещаем остановку в массив остановок
-                stops_on_route.push_back(stop_cur);  // было с move, но т.к. возвращаем const указатель, то перемещать нельзя
-            }
-            // если не нашлась, то остановка не будет добавлена
-            // можно добавлять "пустую" остановку, имеющую только имя
-        }
-
         // заполняем информацию о маршруте
         transport::Bus bus_cur;
         bus_cur.name = bus_name;
-        bus_cur.stops_on_route = stops_on_route;  // было с move
-        bus_cur.unique_stops = std::move(unique_stops);
+        bus_cur.stops = FindStopsIds(stops_names);
         bus_cur.is_round = round_flag;
 
         // добавляем маршрут в справочник 
@@ -215,6 +232,79 @@ struct TransportCatalogue::Impl {
     }
 
 
+    // Заменяет список остановок существующего маршрута. Если маршрута или какой-то из остановок не существует
+    // или не задано расстояние между соседними остановками, выбросит исключение invalid_argument,
+    // ничего не меняя (подписчики ничего не получат)
+    void ReplaceBus(std::string_view bus_name, const std::vector<std::string_view>& stops_names, bool round_flag) {
+        Bus* bus_ptr = FindMutableBus(bus_name);
+        if (!bus_ptr) {
+            throw std::invalid_argument("Unknown bus's name"s);
+        }
+        std::vector<StopId> stops_ids;
+        stops_ids.reserve(stops_names.size());
+        for (std::string_view stop_name : stops_names) {
+            const Stop* stop_ptr = FindStop(stop_name);
+            if (!stop_ptr) {
+                throw std::invalid_argument("Unknown stop's name: "s + std::string(stop_name));
+            }
+            stops_ids.push_back(stop_ptr->id);
+        }
+        // расстояние в обратную сторону (обратный ход некольцевого маршрута) при необходимости берется
+        // из прямого, поэтому достаточно проверить пары соседних остановок в одну сторону
+        for (size_t i = 1; i < stops_ids.size(); ++i) {
+            const Stop* stop_A = GetStopById(stops_ids[i - 1]);
+            const Stop* stop_B = GetStopById(stops_ids[i]);
+            if (!HasDistanceBetweenStops(stop_A, stop_B)) {
+                throw std::invalid_argument("Unknown distance between "s + stop_A->name + " and "s + stop_B->name);
+            }
+        }
+
+        // затронуты и остановки старого маршрута, и остановки нового
+        std::vector<const Stop*> touched_stops = DetachBusFromStops(bus_ptr);
+        bus_ptr->stops = std::move(stops_ids);
+        bus_ptr->is_round = round_flag;
+        AttachBusToStops(bus_ptr);
+        for (StopId stop_id : GetUniqueStops(*bus_ptr)) {
+            touched_stops.push_back(GetStopById(stop_id));
+        }
+
+        InvalidateBusStats({bus_ptr});
+        Notify({CatalogueChange::Type::BUS_REPLACED, std::move(touched_stops), {bus_ptr}});
+    }
+
+
+    // Удаляет маршрут из каталога, если маршрута не существует, выбросит исключение invalid_argument
+    // Сам объект маршрута остается в деке (без остановок), чтобы не сдвигать остальные маршруты
+    void RemoveBus(std::string_view bus_name) {
+        Bus* bus_ptr = FindMutableBus(bus_name);
+        if (!bus_ptr) {
+            throw std::invalid_argument("Unknown bus's name"s);
+        }
+        std::vector<const Stop*> touched_stops = DetachBusFromStops(bus_ptr);
+        buses_dictionary_.erase(bus_ptr->name);
+        buses_removed_[bus_ptr->id] = true;
+        bus_ptr->stops.clear();
+        bus_ptr->unique_stops_count = 0;
+
+        InvalidateBusStats({bus_ptr});
+        Notify({CatalogueChange::Type::BUS_REMOVED, std::move(touched_stops), {bus_ptr}});
+    }
+
+
+    // Подписывает на изменения каталога, возвращает номер подписки
+    size_t Subscribe(ChangeListener listener) {
+        listeners_.emplace_back(next_subscription_id_, std::move(listener));
+        return next_subscription_id_++;
+    }
+
+
+    void Unsubscribe(size_t subscription_id) {
+        listeners_.erase(std::remove_if(listeners_.begin(), listeners_.end(), [subscription_id](const auto& listener) {
+            return listener.first == subscription_id;
+        }), listeners_.end());
+    }
+
+
     const Stop* FindStop(std::string_view stop_name) const{
         // если запрашиваемой остановки нет в базе, то возвращаем пустую "остановку"
         if (!stops_dictionary_.count(stop_name)) {
@@ -224,6 +314,15 @@ struct TransportCatalogue::Impl {
     }
 
 
+    // Возвращает остановку по её id, если такой остановки нет - nullptr
+    const Stop* GetStopById(StopId stop_id) const {
+        if (stop_id >= stops_.size()) {
+            return nullptr;
+        }
+        return &stops_[stop_id];
+    }
+
+
     const Bus* FindBus(std::string_view bus_name) const {
         if (!buses_dictionary_.count(bus_name)) {
             return nullptr;
@@ -232,21 +331,54 @@ struct TransportCatalogue::Impl {
     }
 
 
+    // Возвращает маршрут по его id, если такого маршрута нет или он удален - nullptr
+    const Bus* GetBusById(BusId bus_id) const {
+        // удаленный маршрут остается в деке, но помечается в buses_removed_
+        if (bus_id >= buses_.size() || buses_removed_[bus_id]) {
+            return nullptr;
+        }
+        return &buses_[bus_id];
+    }
+
+
 /**
  * Возвращает информацию о маршруте в виде структуры BusInfo.
  * Если маршрут не найден, то статусное поле valid_state будет false.
 */
 std::optional<BusInfo> GetBusInfo(std::string_view bus_name) const{
-    const Bus* bus_ptr = FindBus(bus_name);
+    return GetBusInfo(FindBus(bus_name));
+}
+
+// То же по id маршрута - без поиска по названию
+std::optional<BusInfo> GetBusInfoById(BusId bus_id) const {
+    return GetBusInfo(GetBusById(bus_id));
+}
+
+std::optional<BusInfo> GetBusInfo(const Bus* bus_ptr) const {
     if (!domain::IsBus(bus_ptr)) {
         return std::nullopt;
     }
+    // Статистика считается при первом запросе и хранится до изменения маршрута.
+    // Чтение посчитанной статистики не блокирует другие потоки
+    BusStatsCache& stats = bus_stats_[bus_ptr->id];
+    if (!stats.ready.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> guard(bus_stats_mutex_);
+        if (!stats.ready.load(std::memory_order_relaxed)) {
+            stats.info = ComputeBusInfo(bus_ptr);
+            stats.ready.store(true, std::memory_order_release);
+        }
+    }
+    return stats.info;
+}
+
+// Считает статистику маршрута
+BusInfo ComputeBusInfo(const Bus* bus_ptr) const {
     BusInfo bus_info;
     // bus_info.valid_state = true;  // автобус есть
     bus_info.name = bus_ptr->name;  // добавляем имя
-    bus_info.num_of_stops_on_route = bus_ptr->stops_on_route.size();  // добавляем количество всех остановок
-    bus_info.num_of_unique_stops = bus_ptr->unique_stops.size();  // // добавляем количество уникальных остановки
-    bus_info.geo_route_length = domain::ComputeGeoRouteLength(bus_ptr);  // считаем и добавляем длину прямого пути
+    bus_info.num_of_stops_on_route = domain::GetRouteStopsCount(*bus_ptr);  // добавляем количество всех остановок
+    bus_info.num_of_unique_stops = bus_ptr->unique_stops_count;  // добавляем количество уникальных остановок
+    bus_info.geo_route_length = ComputeGeoRouteLength(bus_ptr);  // считаем и добавляем длину прямого пути
     bus_info.roads_route_length = ComputeRoadRouteLength(bus_ptr); // считаем и добавляем длину пути по дорогам
 
     return bus_info;
@@ -260,14 +392,22 @@ std::optional<BusInfo> GetBusInfo(std::string_view bus_name) const{
      * Если остановка есть, но автобусы через нее не проходят, то buses_list будет пуст
     */
 std::optional<StopInfo> GetStopInfo(std::string_view stop_name) const {
-    const Stop* stop_ptr = FindStop(stop_name);
+    return GetStopInfo(FindStop(stop_name));
+}
+
+// То же по id остановки - без поиска по названию
+std::optional<StopInfo> GetStopInfoById(StopId stop_id) const {
+    return GetStopInfo(GetStopById(stop_id));
+}
+
+std::optional<StopInfo> GetStopInfo(const Stop* stop_ptr) const {
     if (!domain::IsStop(stop_ptr)) {
         return std::nullopt;
         // return StopInfo{};
     }
 
     // вытаскиваем автобусы по данной остановке, список автобусов м.б. пуст
-    std::vector<std::string_view> buses_at_stop = busses_at_stop_.at(stop_name);
+    std::vector<const Bus*> buses_at_stop = busses_at_stop_[stop_ptr->id];
     
     /* 
     // Не знаю, как правильно выводить, если автобусов нет: пустой массив или nullopt, ранее тесты прошли с выводом пустого массива вместо nullopt
@@ -277,9 +417,18 @@ std::optional<StopInfo> GetStopInfo(std::string_view stop_name) const {
     */
 
     // сортируем по алфавиту
-    std::sort(buses_at_stop.begin(), buses_at_stop.end());
-    // формируем выходную информацию
-    StopInfo stop_info = {std::string(stop_name), buses_at_stop};
+    std::sort(buses_at_stop.begin(), buses_at_stop.end(), [](const Bus* lhs, const Bus* rhs) {
+        return lhs->name < rhs->name;
+    });
+    // формируем выходную информацию: названия и id маршрутов
+    StopInfo stop_info;
+    stop_info.name = stop_ptr->name;
+    stop_info.buses_list.reserve(buses_at_stop.size());
+    stop_info.buses_ids.reserve(buses_at_stop.size());
+    for (const Bus* bus_ptr : buses_at_stop) {
+        stop_info.buses_list.push_back(bus_ptr->name);
+        stop_info.buses_ids.push_back(bus_ptr->id);
+    }
 
     return stop_info;
 }
@@ -332,7 +481,7 @@ std::vector<const Stop*> GetStopsBusPassingThrough() const {
     std::vector<const Stop*> stops_having_buses;
     for (const auto& stop : stops_with_buses_going_through_them_) {
         // Дополнительная проверка, что на остановке есть автобусы
-        if (busses_at_stop_.at(stop->name).size() > 0) {
+        if (busses_at_stop_[stop->id].size() > 0) {
             stops_having_buses.push_back(stop);
         }
     }
@@ -367,6 +516,11 @@ std::optional<int> GetDistanceBetweenStops(const Stop* stop_A, const Stop* stop_
     return distance;
 }
 
+// Проверяет, задано ли расстояние от A до B (или от B до A) для существующих остановок
+bool HasDistanceBetweenStops(const Stop* stop_A, const Stop* stop_B) const {
+    return distances_.count(std::make_pair(stop_A, stop_B)) > 0 || distances_.count(std::make_pair(stop_B, stop_A)) > 0;
+}
+
 // Возвращает расстояние между остановками, если остановок не существует, выбросит исключение invalid_argument
 std::optional<int> GetDistanceBetweenStops(std::string_view stop_A_name, std::string_view stop_B_name) const {
     const Stop* stop_A = FindStop(stop_A_name);
@@ -380,33 +534,173 @@ std::optional<int> GetDistanceBetweenStops(std::string_view stop_A_name, std::st
 
 
 private:
+    // Посчитанная статистика маршрута, ready = false - нужно пересчитать
+    struct BusStatsCache {
+        std::atomic<bool> ready = false;
+        BusInfo info;
+    };
+
     std::deque<Stop> stops_;
     std::unordered_map<std::string_view, Stop*> stops_dictionary_;
 
     std::deque<Bus> buses_;
     std::unordered_map<std::string_view, Bus*> buses_dictionary_;
+    // статистика по маршрутам, индекс - id маршрута
+    mutable std::deque<BusStatsCache> bus_stats_;
+    mutable std::mutex bus_stats_mutex_;
+    // признак удаленного (или замененного маршрутом с тем же названием) маршрута, индекс - id маршрута
+    std::vector<bool> buses_removed_;
 
-    std::unordered_map<std::string_view, std::vector<std::string_view>> busses_at_stop_;
+    // автобусы, проходящие через остановку, индекс - id остановки
+    std::vector<std::vector<const Bus*>> busses_at_stop_;
 
     std::unordered_map<StopsPair, int, StopsPairHasher> distances_; 
 
     std::unordered_set<const Stop*, StopHasher> stops_with_buses_going_through_them_;
 
+    std::vector<std::pair<size_t, ChangeListener>> listeners_;
+    size_t next_subscription_id_ = 0;
+
+
+    Bus* FindMutableBus(std::string_view bus_name) {
+        const auto it = buses_dictionary_.find(bus_name);
+        return it == buses_dictionary_.end() ? nullptr : it->second;
+    }
+
+    // Возвращает id найденных остановок, неизвестные остановки пропускаются
+    std::vector<StopId> FindStopsIds(const std::vector<std::string_view>& stops_names) const {
+        std::vector<StopId> stops_ids;
+        stops_ids.reserve(stops_names.size());
+        for (std::string_view stop_name_cur : stops_names) {
+            // ищем остановку в справочнике
+            const transport::Stop* stop_cur = FindStop(stop_name_cur);
+            // если нашлась, то добавляем в список остановок по автобусу
+            if (stop_cur) {
+                stops_ids.push_back(stop_cur->id);
+            }
+            // если не нашлась, то остановка не будет добавлена
+            // можно добавлять "пустую" остановку, имеющую только имя
+        }
+        return stops_ids;
+    }
+
+    // Возвращает отсортированные id уникальных остановок маршрута
+    static std::vector<StopId> GetUniqueStops(const Bus& bus) {
+        std::vector<StopId> unique_stops = bus.stops;
+        std::sort(unique_stops.begin(), unique_stops.end());
+        unique_stops.erase(std::unique(unique_stops.begin(), unique_stops.end()), unique_stops.end());
+        return unique_stops;
+    }
+
+    // Добавляет автобус в списки автобусов его остановок и запоминает число уникальных остановок 
+    void AttachBusToStops(Bus* bus_ptr) {
+        // набор уникальных остановок нужен только здесь: в маршруте храним лишь их количество
+        const std::vector<StopId> unique_stops = GetUniqueStops(*bus_ptr);
+        bus_ptr->unique_stops_count = static_cast<uint32_t>(unique_stops.size());
+        for (StopId stop_id : unique_stops) {
+            const Stop* stop_ptr = GetStopById(stop_id);
+            stops_with_buses_going_through_them_.insert(stop_ptr);
+            busses_at_stop_[stop_id].push_back(bus_ptr);
+        }
+    }
+
+    // Записывает на остановках маршрута old_bus_ptr вместо него маршрут new_bus_ptr
+    void ReplaceBusAtStops(const Bus* old_bus_ptr, const Bus* new_bus_ptr) {
+        for (StopId stop_id : GetUniqueStops(*old_bus_ptr)) {
+            std::vector<const Bus*>& buses_at_stop = busses_at_stop_[stop_id];
+            std::replace(buses_at_stop.begin(), buses_at_stop.end(), old_bus_ptr, new_bus_ptr);
+        }
+    }
+
+    // Убирает автобус из списков автобусов его остановок, возвращает эти остановки
+    std::vector<const Stop*> DetachBusFromStops(const Bus* bus_ptr) {
+        std::vector<const Stop*> detached_stops;
+        for (StopId stop_id : GetUniqueStops(*bus_ptr)) {
+            const Stop* stop_ptr = GetStopById(stop_id);
+            std::vector<const Bus*>& buses_at_stop = busses_at_stop_[stop_id];
+            buses_at_stop.erase(std::remove(buses_at_stop.begin(), buses_at_stop.end(), bus_ptr), buses_at_stop.end());
+            if (buses_at_stop.empty()) {
+                stops_with_buses_going_through_them_.erase(stop_ptr);
+            }
+            detached_stops.push_back(stop_ptr);
+        }
+        return detached_stops;
+    }
+
+    // Возвращает автобусы, проходящие через остановку
+    std::vector<const Bus*> GetBusesAtStop(const Stop* stop_ptr) const {
+        return busses_at_stop_[stop_ptr->id];
+    }
+
+    // Возвращает автобусы, которые едут между остановками A и B напрямую (соседние остановки маршрута),
+    // то есть маршруты, длина которых зависит от расстояния A->B
+    std::vector<const Bus*> FindBusesDrivingBetween(const Stop* stop_A, const Stop* stop_B) const {
+        // расстояние B->A совпадает с A->B, если не задано явно
+        const bool reverse_follows = !distances_.count(std::make_pair(stop_B, stop_A));
+        std::vector<const Bus*> buses;
+        for (const Bus* bus_ptr : GetBusesAtStop(stop_A)) {
+            const size_t stops_count = domain::GetRouteStopsCount(*bus_ptr);
+            for (size_t i = 1; i < stops_count; ++i) {
+                const StopId from = domain::GetRouteStopId(*bus_ptr, i - 1);
+                const StopId to = domain::GetRouteStopId(*bus_ptr, i);
+                if ((from == stop_A->id && to == stop_B->id) || (reverse_follows && from == stop_B->id && to == stop_A->id)) {
+                    buses.push_back(bus_ptr);
+                    break;
+                }
+            }
+        }
+        return buses;
+    }
+
+    // Меняет координаты остановки и сбрасывает статистику проходящих через неё маршрутов
+    void MoveStop(Stop* stop_ptr, geo::Coordinates coordinates) {
+        stop_ptr->coordinates = coordinates;
+        std::vector<const Bus*> touched_buses = GetBusesAtStop(stop_ptr);
+        InvalidateBusStats(touched_buses);
+        Notify({CatalogueChange::Type::STOP_MOVED, {stop_ptr}, std::move(touched_buses)});
+    }
+
+    void InvalidateBusStats(const std::vector<const Bus*>& buses) {
+        for (const Bus* bus_ptr : buses) {
+            bus_stats_[bus_ptr->id].ready.store(false, std::memory_order_release);
+        }
+    }
+
+    // Сообщает подписчикам об изменении каталога
+    void Notify(const CatalogueChange& change) const {
+        for (const auto& [subscription_id, listener] : listeners_) {
+            listener(change);
+        }
+    }
+
+    // Считает длину маршрута по дорогам, включая обратный ход некольцевого маршрута
     double ComputeRoadRouteLength(const Bus* bus) const {
         double roads_length = 0;
+        const size_t stops_count = domain::GetRouteStopsCount(*bus);
         // не имеет смысла считать расстояния, если остановка всего одна
-        if (bus->stops_on_route.size() < 2) {
+        if (stops_count < 2) {
             return roads_length;
         }
-        for (size_t i = 0; i < bus->stops_on_route.size() - 1; i++) {
-            const Stop* stop_A = bus->stops_on_route[i];
-            const Stop* stop_B = bus->stops_on_route[i+1];
+        for (size_t i = 0; i < stops_count - 1; i++) {
+            const Stop* stop_A = GetStopById(domain::GetRouteStopId(*bus, i));
+            const Stop* stop_B = GetStopById(domain::GetRouteStopId(*bus, i + 1));
             roads_length += *GetDistanceBetweenStops(stop_A, stop_B);
 
         }
         
         return roads_length;    
     }
+
+    // Считает длину маршрута по прямой между остановками, включая обратный ход некольцевого маршрута
+    double ComputeGeoRouteLength(const Bus* bus) const {
+        double route_length = 0;
+        const size_t stops_count = domain::GetRouteStopsCount(*bus);
+        for (size_t i = 1; i < stops_count; i++) {
+            route_length += geo::ComputeDistance(GetStopById(domain::GetRouteStopId(*bus, i))->coordinates, 
+                                                 GetStopById(domain::GetRouteStopId(*bus, i - 1))->coordinates);
+        }
+        return route_length;
+    }
 };
 
 
@@ -450,10 +744,42 @@ const Stop* TransportCatalogue::FindStop(std::string_view stop_name) const {
     return impl_->FindStop(stop_name);
 }
 
+void TransportCatalogue::UpdateStop(std::string_view stop_name, geo::Coordinates coordinates) {
+    impl_->UpdateStop(stop_name, coordinates);
+}
+
+void TransportCatalogue::UpdateDistance(std::string_view stopA_name, std::string_view stopB_name, int distance) {
+    impl_->UpdateDistance(stopA_name, stopB_name, distance);
+}
+
+void TransportCatalogue::ReplaceBus(std::string_view bus_name, const std::vector<std::string_view>& stops_names, bool round_flag) {
+    impl_->ReplaceBus(bus_name, stops_names, round_flag);
+}
+
+void TransportCatalogue::RemoveBus(std::string_view bus_name) {
+    impl_->RemoveBus(bus_name);
+}
+
+size_t TransportCatalogue::Subscribe(ChangeListener listener) {
+    return impl_->Subscribe(std::move(listener));
+}
+
+void TransportCatalogue::Unsubscribe(size_t subscription_id) {
+    impl_->Unsubscribe(subscription_id);
+}
+
+const Stop* TransportCatalogue::GetStopById(StopId stop_id) const {
+    return impl_->GetStopById(stop_id);
+}
+
 const Bus* TransportCatalogue::FindBus(std::string_view bus_name) const {
     return impl_->FindBus(bus_name);
 }
 
+const Bus* TransportCatalogue::GetBusById(BusId bus_id) const {
+    return impl_->GetBusById(bus_id);
+}
+
 std::optional<BusInfo> TransportCatalogue::GetBusInfo(std::string_view bus_name) const{
     return impl_->GetBusInfo(bus_name);
 }
@@ -462,6 +788,14 @@ std::optional<StopInfo> TransportCatalogue::GetStopInfo(std::string_view stop_na
     return impl_->GetStopInfo(stop_name);
 }
 
+std::optional<BusInfo> TransportCatalogue::GetBusInfoById(BusId bus_id) const {
+    return impl_->GetBusInfoById(bus_id);
+}
+
+std::optional<StopInfo> TransportCatalogue::GetStopInfoById(StopId stop_id) const {
+    return impl_->GetStopInfoById(stop_id);
+}
+
 std::vector<std::pair<std::string_view, const Bus*>> TransportCatalogue::GetAllBuses() const {
     return impl_->GetAllBuses();
 }
@@ -4,6 +4,7 @@
 
 #include <string>
 #include <deque>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <unordered_map>
@@ -23,6 +24,25 @@ using StopsPair = std::pair<const Stop*, const Stop*>;
 using DistancesVector = std::vector<std::pair<std::string, int>>;
 
 
+// Описание изменения каталога, которое получают подписчики (маршрутизатор, отрисовщик и т.п.),
+// чтобы пересчитать только затронутые изменением данные
+struct CatalogueChange {
+    enum class Type {
+        STOP_MOVED,        // изменились координаты остановки
+        DISTANCE_CHANGED,  // изменилось расстояние между остановками
+        BUS_ADDED,         // добавлен маршрут
+        BUS_REPLACED,      // изменился список остановок маршрута
+        BUS_REMOVED,       // маршрут удален (объект маршрута остается, но без остановок)
+    };
+
+    Type type;
+    std::vector<const Stop*> stops;  // затронутые остановки
+    std::vector<const Bus*> buses;   // затронутые маршруты
+};
+
+using ChangeListener = std::function<void(const CatalogueChange&)>;
+
+
 
 class TransportCatalogue {
     // Реализуйте класс самостоятельно
@@ -46,13 +66,18 @@ public:
     // Добавляет остановку и расстояния в каталог 
     void AddStop(Stop new_stop, const DistancesVector& distances_to_stops);
 
-    // Добавляет автобус в каталог
+    // Добавляет автобус в каталог (остановки маршрута задаются id)
     void AddBus(Bus new_bus);
     // Добавляет маршрут (автобус) и его остановки в каталог
+    // Для некольцевого маршрута передаются остановки только прямого хода (до конечной включительно)
     void AddBus(std::string_view bus_name, const std::vector<std::string_view>& stops_names, bool round_flag);
 
     const Stop* FindStop(std::string_view stop_name) const;
+    // Возвращает остановку по её id, если такой остановки нет - nullptr
+    const Stop* GetStopById(StopId stop_id) const;
     const Bus* FindBus(std::string_view bus_name) const;
+    // Возвращает маршрут по его id, если такого маршрута нет или он удален - nullptr
+    const Bus* GetBusById(BusId bus_id) const;
 
     /** 
      * возвращает инфу по маршруту (список остановок) в виде структуры
@@ -67,6 +92,10 @@ public:
     */
     std::optional<StopInfo> GetStopInfo(std::string_view stop_name) const;
 
+    // То же по id маршрута и остановки (без поиска по названию), для неизвестного id - nullopt
+    std::optional<BusInfo> GetBusInfoById(BusId bus_id) const;
+    std::optional<StopInfo> GetStopInfoById(StopId stop_id) const;
+
 
     /*
     Возвращает вектор всех автобусов в сортированном порядке
@@ -92,6 +121,28 @@ public:
     void SetDistanceBetweenStops(std::string_view stopA_name, std::string_view stopB_name, int distance);
 
 
+    /*
+    Изменение уже заполненного каталога. 
+    Если указанной остановки или маршрута нет, методы выбросят исключение invalid_argument и ничего не изменят.
+    После каждого изменения подписчики получают CatalogueChange с затронутыми остановками и маршрутами.
+    Изменения не должны выполняться одновременно с запросами к каталогу из других потоков
+    */
+
+    // Меняет координаты остановки
+    void UpdateStop(std::string_view stop_name, geo::Coordinates coordinates);
+    // Меняет расстояние от остановки A до остановки B (и от B до A, если оно не задано отдельно)
+    void UpdateDistance(std::string_view stopA_name, std::string_view stopB_name, int distance);
+    // Заменяет остановки маршрута (для некольцевого - только прямой ход). Кроме случая, когда маршрута нет,
+    // выбросит invalid_argument, если нет какой-то из остановок или расстояния между соседними остановками
+    void ReplaceBus(std::string_view bus_name, const std::vector<std::string_view>& stops_names, bool round_flag);
+    // Удаляет маршрут
+    void RemoveBus(std::string_view bus_name);
+
+    // Подписывает на изменения каталога, возвращает номер подписки для отписки
+    size_t Subscribe(ChangeListener listener);
+    void Unsubscribe(size_t subscription_id);
+
+
 
 private:
     struct Impl;
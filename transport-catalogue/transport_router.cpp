@@ -1,5 +1,6 @@
 #include "transport_router.h"
 
+#include <algorithm>
 #include <string>
 #include <iostream>
 
@@ -61,10 +62,19 @@ std::optional<StopVertexes> TransportGraphMaker::GetStopIndexesByName(std::strin
     return stop_vs_indexes_.at(stop_name);
 }
 
+bool TransportGraphMaker::IsStopServed(std::string_view stop_name) const {
+    const std::optional<domain::StopInfo> stop_info = tc_.GetStopInfo(stop_name);
+    return stop_info.has_value() && !stop_info->buses_list.empty();
+}
+
 std::string_view TransportGraphMaker::GetStopNameByIndex(size_t ind) const {
     /* if (ind > index_vs_stop_.size()) {
         throw std::out_of_range("LOG err: In TransportGraphMaker::GetStopNameByIndex - Index exceed graph size"s);
     } */
+    return index_vs_stop_.at(ind)->name;
+}
+
+const domain::Stop* TransportGraphMaker::GetStopByIndex(size_t ind) const {
     return index_vs_stop_.at(ind);
 }
 
@@ -76,13 +86,18 @@ std::string_view TransportGraphMaker::GetBusNameByIndex(size_t ind) const {
     return index_vs_buses_.at(ind).first;
 }
 
+const domain::Bus* TransportGraphMaker::GetBusByIndex(size_t ind) const {
+    return index_vs_buses_.at(ind).second;
+}
+
 std::size_t TransportGraphMaker::GetBusIndexByName(std::string_view bus_name) const {
     return buses_vs_index_.at(bus_name);
 }
 
 
 // Добавляет остановку, если её еще нет в базе вершин и возвращает индексы соответствующих остановке узлов
-const StopVertexes& TransportGraphMaker::AddStopAndGetIndexes(std::string_view stop_name) {
+const StopVertexes& TransportGraphMaker::AddStopAndGetIndexes(const domain::Stop* stop_ptr) {
+    std::string_view stop_name = stop_ptr->name;
     // случай 1 - остановки ещё не в списке вершин
     if (!stop_vs_indexes_.count(stop_name)) {
         size_t n = index_vs_stop_.size();
@@ -94,15 +109,18 @@ const StopVertexes& TransportGraphMaker::AddStopAndGetIndexes(std::string_view s
         // добавляем в map 
         stop_vs_indexes_[stop_name] = (new_stop_indexes);
         // добавляем в vector остановок
-        index_vs_stop_.push_back(stop_name);
-        index_vs_stop_.push_back(stop_name);
+        index_vs_stop_.push_back(stop_ptr);
+        index_vs_stop_.push_back(stop_ptr);
 
         // добавляем ребро между кусками остановки from и to
         EdgeWeight one_stop_weight({static_cast<Duration>(settings_.bus_wait_time), -1, 0});
 
-        // to do: скорее всего нужно оставить только вторую из этих двух строчек:
-        // edges_.emplace_back(new_stop_indexes.depart_ind, new_stop_indexes.arrive_ind, one_stop_weight);
-        edges_.emplace_back(new_stop_indexes.arrive_ind, new_stop_indexes.depart_ind, one_stop_weight);
+        // в уже построенный граф добавляем и вершины новой остановки
+        if (graph_) {
+            graph_->AddVertex();
+            graph_->AddVertex();
+        }
+        AddEdge({new_stop_indexes.arrive_ind, new_stop_indexes.depart_ind, one_stop_weight});
 
         // проверяем адекватность добавления
         if (index_vs_stop_.size() != (n + 2)) {
@@ -113,29 +131,109 @@ const StopVertexes& TransportGraphMaker::AddStopAndGetIndexes(std::string_view s
     return stop_vs_indexes_.at(stop_name);
 }
 
-void TransportGraphMaker::ParseAndFillLinearBusTrack(const domain::Bus* bus_ptr) {
-    const StopsList& stops = bus_ptr->stops_on_route; 
-    size_t n_stops = stops.size();
-    // to do: возможно, нужно сдвигать итератор лишь на n/2 без доп +1
-    const auto it_final_stop = std::next(stops.begin(), n_stops/2);
+graph::EdgeId TransportGraphMaker::AddEdge(const graph::Edge<EdgeWeight>& edge) {
+    if (graph_) {
+        return graph_->AddEdge(edge);
+    }
+    // граф заполняется ребрами в том же порядке, поэтому id ребра - его номер в edges_
+    edges_.push_back(edge);
+    return edges_.size() - 1;
+}
+
+void TransportGraphMaker::ParseAndFillLinearBusTrack(const domain::Bus* bus_ptr, size_t bus_ind, std::vector<graph::Edge<EdgeWeight>>& route_edges) {
+    // остановки некольцевого маршрута хранятся только для прямого хода
+    const StopsList& stops = bus_ptr->stops; 
     
     // Добавляем ребра - возможные поездки на автобусе без пересадок 
-    // от начала маршрута до конечной (середины) и от середины до конца
-    AddRouteEdges(stops.begin(), std::next(it_final_stop), bus_ptr->name);
-    AddRouteEdges(it_final_stop, stops.end(), bus_ptr->name);
+    // от начала маршрута до конечной и обратно (обратный ход - проход по остановкам в обратном порядке)
+    AddRouteEdges(stops.begin(), stops.end(), bus_ind, route_edges);
+    AddRouteEdges(stops.rbegin(), stops.rend(), bus_ind, route_edges);
 
     return;
 }
 
-void TransportGraphMaker::ParseAndFillRoundBusTrack(const domain::Bus* bus_ptr) {
-    const StopsList& stops = bus_ptr->stops_on_route; 
+void TransportGraphMaker::ParseAndFillRoundBusTrack(const domain::Bus* bus_ptr, size_t bus_ind, std::vector<graph::Edge<EdgeWeight>>& route_edges) {
+    const StopsList& stops = bus_ptr->stops; 
     
     // Добавляем ребра - возможные поездки на автобусе без пересадок 
     // от начала маршрута до конечной
-    AddRouteEdges(stops.begin(), stops.end(), bus_ptr->name);
+    AddRouteEdges(stops.begin(), stops.end(), bus_ind, route_edges);
     return;
 }
 
+std::vector<graph::Edge<EdgeWeight>> TransportGraphMaker::MakeBusEdges(const domain::Bus* bus_ptr, size_t bus_ind) {
+    std::vector<graph::Edge<EdgeWeight>> route_edges;
+    if (bus_ptr->is_round) {
+        ParseAndFillRoundBusTrack(bus_ptr, bus_ind, route_edges); 
+    }
+    else {
+        ParseAndFillLinearBusTrack(bus_ptr, bus_ind, route_edges);
+    }
+    return route_edges;
+}
+
+size_t TransportGraphMaker::GetOrAddBusIndex(const domain::Bus* bus_ptr) {
+    const auto it = buses_vs_index_.find(bus_ptr->name);
+    if (it != buses_vs_index_.end()) {
+        return static_cast<size_t>(it->second);
+    }
+    // индексы уже добавленных автобусов не меняются: они записаны в веса ребер
+    const size_t bus_ind = index_vs_buses_.size();
+    index_vs_buses_.emplace_back(bus_ptr->name, bus_ptr);
+    buses_vs_index_[bus_ptr->name] = static_cast<int>(bus_ind);
+    bus_edges_.emplace_back();
+    return bus_ind;
+}
+
+void TransportGraphMaker::UpdateBusEdges(const domain::Bus* bus_ptr, std::vector<graph::EdgeId>& changed_edges) {
+    const size_t bus_ind = GetOrAddBusIndex(bus_ptr);
+    const std::vector<graph::Edge<EdgeWeight>> new_edges = MakeBusEdges(bus_ptr, bus_ind);
+    std::vector<graph::EdgeId>& edge_ids = bus_edges_[bus_ind];
+
+    // Проверяем, соединяют ли новые ребра те же вершины, что и старые
+    bool same_vertexes = (new_edges.size() == edge_ids.size());
+    for (size_t i = 0; same_vertexes && i < new_edges.size(); ++i) {
+        const graph::Edge<EdgeWeight>& old_edge = graph_->GetEdge(edge_ids[i]);
+        same_vertexes = (old_edge.from == new_edges[i].from && old_edge.to == new_edges[i].to);
+    }
+
+    if (same_vertexes) {
+        // меняем только веса
+        for (size_t i = 0; i < new_edges.size(); ++i) {
+            const EdgeWeight& old_weight = graph_->GetEdge(edge_ids[i]).weight;
+            if (old_weight.duration != new_edges[i].weight.duration || old_weight.span_count != new_edges[i].weight.span_count) {
+                graph_->SetEdgeWeight(edge_ids[i], new_edges[i].weight);
+                changed_edges.push_back(edge_ids[i]);
+            }
+        }
+        return;
+    }
+
+    // иначе заменяем ребра маршрута целиком
+    for (graph::EdgeId edge_id : edge_ids) {
+        graph_->RemoveEdge(edge_id);
+        changed_edges.push_back(edge_id);
+    }
+    edge_ids.clear();
+    for (const graph::Edge<EdgeWeight>& edge : new_edges) {
+        edge_ids.push_back(graph_->AddEdge(edge));
+        changed_edges.push_back(edge_ids.back());
+    }
+}
+
+std::vector<graph::EdgeId> TransportGraphMaker::ApplyCatalogueChange(const transport::CatalogueChange& change) {
+    std::vector<graph::EdgeId> changed_edges;
+    // время в пути зависит только от расстояний по дорогам, координаты остановок на граф не влияют
+    if (change.type == transport::CatalogueChange::Type::STOP_MOVED) {
+        return changed_edges;
+    }
+    for (const domain::Bus* bus_ptr : change.buses) {
+        UpdateBusEdges(bus_ptr, changed_edges);
+    }
+    stop_vertex_number_ = index_vs_stop_.size();
+    return changed_edges;
+}
+
 // Формирует таблицу индексов остановок (узлов будущего графа) и хеш-таблицу (вектор) ребер
 void TransportGraphMaker::FillContainersWithStopsAndEdges(const BusesList& buses) {
     // инициализируем начальные индексы и остановки - это необходимо для заполнения хеш-таблицы путей
@@ -149,12 +247,12 @@ void TransportGraphMaker::FillContainersWithStopsAndEdges(const BusesList& buses
         }
         buses_vs_index_[bus_name] = cur_bus_ind;
 
-        if (bus_ptr->is_round) {
-            ParseAndFillRoundBusTrack(bus_ptr); 
-        }
-        else {
-            ParseAndFillLinearBusTrack(bus_ptr);
+        // запоминаем id ребер маршрута, чтобы потом обновлять их по отдельности
+        std::vector<graph::EdgeId> edge_ids;
+        for (const graph::Edge<EdgeWeight>& edge : MakeBusEdges(bus_ptr, cur_bus_ind)) {
+            edge_ids.push_back(AddEdge(edge));
         }
+        bus_edges_.push_back(std::move(edge_ids));
 
         // обязательно инкрементировать автобусный индекс 
         cur_bus_ind++;
@@ -203,10 +301,11 @@ std::pair<TransportRouteItems, Duration> TransportRouter::CreateTransportRouteFr
     graph::EdgeId first_edge_id = route_info.edges.at(0);
     // первая остановка
     size_t first_stop_ind = graph_maker_.GetGraph().GetEdge(first_edge_id).from;
-    std::string_view first_stop = graph_maker_.GetStopNameByIndex(first_stop_ind);
+    const domain::Stop* first_stop = graph_maker_.GetStopByIndex(first_stop_ind);
     
     // добавляем ожидание первого транспорта в Items
-    WaitRouteItem first_item(/*название первой остановки*/std::string(first_stop), static_cast<Duration>(graph_maker_.GetSettings().bus_wait_time));
+    WaitRouteItem first_item(/*название первой остановки*/first_stop->name, static_cast<Duration>(graph_maker_.GetSettings().bus_wait_time));
+    first_item.stop_id = first_stop->id;
     MoveWaitItemToList(first_item, items, duration_total);
 
     // идем по вектору id ребер и собираем информацию. 
@@ -230,6 +329,7 @@ std::pair<TransportRouteItems, Duration> TransportRouter::CreateTransportRouteFr
             // Добавляем item ожидания
             wait_item.duration = edge_cur.weight.duration;
             wait_item.stop = std::string(first_stop_name);
+            wait_item.stop_id = graph_maker_.GetStopByIndex(edge_cur.from)->id;
 
             MoveWaitItemToList(wait_item, items, duration_total);
             wait_item.Clear();  // на всякий случай очищаем
@@ -240,7 +340,9 @@ std::pair<TransportRouteItems, Duration> TransportRouter::CreateTransportRouteFr
                 throw std::logic_error("LOG err: in GetRoute Can\'t write new bus trip because the previous is not empty"s);
             }
             // формируем новую поездку
-            bus_item.bus = graph_maker_.GetBusNameByIndex(static_cast<size_t>(bus_ind));
+            const domain::Bus* bus_ptr = graph_maker_.GetBusByIndex(static_cast<size_t>(bus_ind));
+            bus_item.bus = bus_ptr->name;
+            bus_item.bus_id = bus_ptr->id;
             bus_item.span_count = edge_cur.weight.span_count;
             bus_item.duration = edge_cur.weight.duration;
             
@@ -259,6 +361,16 @@ std::pair<TransportRouteItems, Duration> TransportRouter::CreateTransportRouteFr
 }
 
 
+void TransportRouter::OnCatalogueChanged(const transport::CatalogueChange& change) {
+    const std::vector<graph::EdgeId> changed_edges = graph_maker_.ApplyCatalogueChange(change);
+    if (changed_edges.empty()) {
+        return;
+    }
+    // пересчитываются только кратчайшие пути, которые могли измениться
+    router_->UpdateEdges(changed_edges);
+}
+
+
 std::optional<std::pair<TransportRouteItems, Duration>> TransportRouter::GetRouteInfo(std::string_view from_stop, std::string_view to_stop) const {
     // 0. Определяем индексы остановок отправления и назначения
     std::optional<StopVertexes> from_stop_inds = graph_maker_.GetStopIndexesByName(from_stop);
@@ -270,6 +382,9 @@ std::optional<std::pair<TransportRouteItems, Duration>> TransportRouter::GetRout
     std::optional<GraphRouteInfo> fast_route;
 
     if (from_stop == to_stop) {
+        if (!graph_maker_.IsStopServed(from_stop)) {
+            return {};
+        }
         EdgeWeight empty_weight;
         fast_route = {empty_weight, {}};
     }
@@ -289,3 +404,67 @@ std::optional<std::pair<TransportRouteItems, Duration>> TransportRouter::GetRout
     return transport_route_info;
 }
 
+
+std::vector<TransportRouteInfo> TransportRouter::GetRoutesInfo(const std::vector<RouteQuery>& queries, parallel::ThreadPool* thread_pool) const {
+    std::vector<TransportRouteInfo> routes_info(queries.size());
+
+    // 0. Определяем вершины остановок, запросы с неизвестными остановками остаются без ответа (nullopt)
+    struct QueryVertexes {
+        size_t query_ind = 0;
+        graph::VertexId from = 0;
+        graph::VertexId to = 0;
+    };
+    std::vector<QueryVertexes> grouped_queries;
+    grouped_queries.reserve(queries.size());
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const auto& [from_stop, to_stop] = queries[i];
+        std::optional<StopVertexes> from_stop_inds = graph_maker_.GetStopIndexesByName(from_stop);
+        std::optional<StopVertexes> to_stop_inds = graph_maker_.GetStopIndexesByName(to_stop);
+        if (!from_stop_inds || !to_stop_inds) {
+            continue;
+        }
+        // путь от остановки до неё самой - пустой, искать его не нужно
+        if (from_stop == to_stop) {
+            routes_info[i] = GetRouteInfo(from_stop, to_stop);
+            continue;
+        }
+        grouped_queries.push_back({i, from_stop_inds->depart_ind, to_stop_inds->arrive_ind});
+    }
+
+    // 1. Группируем запросы по вершине отправления, сохраняя порядок внутри группы
+    std::stable_sort(grouped_queries.begin(), grouped_queries.end(), [](const QueryVertexes& lhs, const QueryVertexes& rhs) {
+        return lhs.from < rhs.from;
+    });
+
+    std::vector<size_t> group_starts;
+    for (size_t i = 0; i < grouped_queries.size(); ++i) {
+        if (i == 0 || grouped_queries[i].from != grouped_queries[i - 1].from) {
+            group_starts.push_back(i);
+        }
+    }
+    group_starts.push_back(grouped_queries.size());
+
+    // 2. Для каждой группы один раз получаем пути из вершины отправления и восстанавливаем ответы.
+    // Каждая группа пишет только в ячейки своих запросов
+    auto process_group = [&](size_t group_ind) {
+        const size_t group_begin = group_starts[group_ind];
+        const size_t group_end = group_starts[group_ind + 1];
+        const auto source_routes = router_->BuildRoutesFrom(grouped_queries[group_begin].from);
+        for (size_t i = group_begin; i < group_end; ++i) {
+            std::optional<GraphRouteInfo> fast_route = source_routes.BuildRoute(grouped_queries[i].to);
+            if (fast_route) {
+                routes_info[grouped_queries[i].query_ind] = CreateTransportRouteFromGraphRoute(*fast_route);
+            }
+        }
+    };
+    const size_t groups_count = group_starts.size() - 1;
+    if (thread_pool) {
+        thread_pool->ParallelFor(groups_count, process_group);
+    }
+    else {
+        for (size_t group_ind = 0; group_ind < groups_count; ++group_ind) {
+            process_group(group_ind);
+        }
+    }
+    return routes_info;
+}
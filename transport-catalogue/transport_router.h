@@ -3,6 +3,7 @@
 #include "transport_catalogue.h"
 #include "graph.h"
 #include "router.h"
+#include "thread_pool.h"
 
 #include <memory>
 #include <string>
@@ -42,7 +43,7 @@ bool operator>=(const EdgeWeight& lhs, const EdgeWeight& rhs);
 
 
 using BusesList = std::vector<std::pair<std::string_view, const domain::Bus*>>;
-using StopsList = std::vector<const domain::Stop*>;
+using StopsList = std::vector<domain::StopId>;
 using TransportGraph = graph::DirectedWeightedGraph<EdgeWeight>;
 
 
@@ -83,13 +84,26 @@ public:
     const TransportGraph& GetGraph() const;
 
     std::optional<StopVertexes> GetStopIndexesByName(std::string_view stop_name) const;
+    // Проверяет, проходят ли через остановку автобусы. 
+    // Вершины остановки остаются в графе и после удаления всех её маршрутов
+    bool IsStopServed(std::string_view stop_name) const;
     std::string_view GetStopNameByIndex(size_t ind) const;
+    const domain::Stop* GetStopByIndex(size_t ind) const;
 
     const RoutingSettings& GetSettings() const;
 
     std::string_view GetBusNameByIndex(size_t ind) const;
+    const domain::Bus* GetBusByIndex(size_t ind) const;
     std::size_t GetBusIndexByName(std::string_view bus_name) const;
 
+    /*
+    Обновляет граф после изменения каталога: пересчитываются только ребра затронутых маршрутов.
+    Если ребра маршрута соединяют те же вершины, меняются только их веса, 
+    иначе старые ребра удаляются из графа и добавляются новые.
+    Возвращает id изменившихся (в том числе удаленных и добавленных) ребер
+    */
+    std::vector<graph::EdgeId> ApplyCatalogueChange(const transport::CatalogueChange& change);
+
 
 private:
     const transport::TransportCatalogue& tc_;
@@ -103,9 +117,11 @@ private:
     // хранение остановок и их узлов, 
     // в паре соответственно: first - узел отправления, second - узел прибытия
     std::unordered_map<std::string_view, StopVertexes> stop_vs_indexes_; 
-    std::vector<std::string_view> index_vs_stop_;
+    std::vector<const domain::Stop*> index_vs_stop_;
     size_t stop_vertex_number_;
     std::vector<graph::Edge<EdgeWeight>> edges_;
+    // id ребер каждого маршрута, индекс - индекс автобуса
+    std::vector<std::vector<graph::EdgeId>> bus_edges_;
 
     double bus_velocity_in_m_per_minute_ = 0.0;
 
@@ -119,6 +135,8 @@ private:
             graph_tmp->AddEdge(edge_cur);
         }
         graph_ = std::move(graph_tmp);
+        // дальше ребра добавляются сразу в граф
+        edges_.clear();
 
         // PrintGraph();
 
@@ -130,23 +148,29 @@ private:
     }
 
 
-    const StopVertexes& AddStopAndGetIndexes(std::string_view stop_name);
+    const StopVertexes& AddStopAndGetIndexes(const domain::Stop* stop_ptr);
+
+    // Добавляет ребро в список ребер будущего графа или, если граф уже построен, сразу в граф
+    graph::EdgeId AddEdge(const graph::Edge<EdgeWeight>& edge);
 
-    // Формирует по списку остановок узлы графа - маршруты между остановками 
+    // Формирует по списку id остановок ребра графа - поездки между остановками - и добавляет их в route_edges
     template<typename Iterator>
-    void AddRouteEdges(Iterator it_start, Iterator it_end, std::string_view bus_name) {
+    void AddRouteEdges(Iterator it_start, Iterator it_end, size_t bus_ind, std::vector<graph::Edge<EdgeWeight>>& route_edges) {
         for (auto it_from = it_start; it_from != it_end; it_from++) {
+            const domain::Stop* from_stop_ptr = tc_.GetStopById(*it_from);
+            std::string_view from_stop_name = from_stop_ptr->name;
             // добавляем остановку (если она новая) и получаем индексы её вершин в будущем графе
-            const StopVertexes& stop_from_vertexes = AddStopAndGetIndexes((*it_from)->name);
+            const StopVertexes& stop_from_vertexes = AddStopAndGetIndexes(from_stop_ptr);
             int distance = 0;
             int span_count = 0;
-            std::string_view prev_to_stop_name = (*it_from)->name;
+            std::string_view prev_to_stop_name = from_stop_name;
     
             for (auto it_to = std::next(it_from); it_to != it_end; it_to++) {
-                std::string_view cur_to_stop_name = (*it_to)->name;
+                const domain::Stop* cur_to_stop_ptr = tc_.GetStopById(*it_to);
+                std::string_view cur_to_stop_name = cur_to_stop_ptr->name;
 
                 // добавляем остановку (если она новая) и получаем индексы её вершин в будущем графе
-                const StopVertexes& stop_to_vertexes = AddStopAndGetIndexes(cur_to_stop_name);
+                const StopVertexes& stop_to_vertexes = AddStopAndGetIndexes(cur_to_stop_ptr);
                 
                 // Накапливаем расстояние, удаляясь от остановки отправления
                 // Тут подразумеваем, что расстояние однозначно определено, 
@@ -155,12 +179,11 @@ private:
                 // Считаем время в пути
                 Duration duration = (distance * 1.0) / bus_velocity_in_m_per_minute_;  // * 1.0 для приведения к double
                 span_count += 1;
-                std::size_t cur_bus_ind = GetBusIndexByName(bus_name);
-                EdgeWeight cur_weight({duration, static_cast<int>(cur_bus_ind), span_count});
+                EdgeWeight cur_weight({duration, static_cast<int>(bus_ind), span_count});
                 
                 // Формируем и добавляем новое ребро: 
                 // от остановки из внешнего цикла до текущей остановки из внутреннего цикла
-                edges_.emplace_back(stop_from_vertexes.depart_ind, stop_to_vertexes.arrive_ind, cur_weight);
+                route_edges.push_back({stop_from_vertexes.depart_ind, stop_to_vertexes.arrive_ind, cur_weight});
 
                 // обновляем предыдущую остановку для следующей итерации
                 prev_to_stop_name = cur_to_stop_name;
@@ -170,8 +193,17 @@ private:
         return;
     }
 
-    void ParseAndFillLinearBusTrack(const domain::Bus* bus_ptr);
-    void ParseAndFillRoundBusTrack(const domain::Bus* bus_ptr);
+    void ParseAndFillLinearBusTrack(const domain::Bus* bus_ptr, size_t bus_ind, std::vector<graph::Edge<EdgeWeight>>& route_edges);
+    void ParseAndFillRoundBusTrack(const domain::Bus* bus_ptr, size_t bus_ind, std::vector<graph::Edge<EdgeWeight>>& route_edges);
+
+    // Возвращает индекс автобуса, новому автобусу назначает следующий свободный индекс
+    size_t GetOrAddBusIndex(const domain::Bus* bus_ptr);
+
+    // Формирует ребра маршрута (для удаленного маршрута - пустой список)
+    std::vector<graph::Edge<EdgeWeight>> MakeBusEdges(const domain::Bus* bus_ptr, size_t bus_ind);
+
+    // Пересчитывает ребра одного маршрута в построенном графе, id изменившихся ребер добавляет в changed_edges
+    void UpdateBusEdges(const domain::Bus* bus_ptr, std::vector<graph::EdgeId>& changed_edges);
 
     // Формирует таблицу индексов остановок (узлов будущего графа) и хеш-таблицу (вектор) ребер
     void FillContainersWithStopsAndEdges(const BusesList& buses); 
@@ -183,6 +215,7 @@ private:
 struct BusRouteItem {
     const std::string type = "Bus";
     std::string bus;
+    domain::BusId bus_id = 0;
     int span_count = 0;
     Duration duration = 0;
     
@@ -195,6 +228,7 @@ struct BusRouteItem {
 
     void Clear() {
         bus.clear();
+        bus_id = 0;
         span_count = 0;
         duration = 0;
     }
@@ -207,6 +241,7 @@ struct BusRouteItem {
 struct WaitRouteItem {
     const std::string type = "Wait"; 
     std::string stop;
+    domain::StopId stop_id = 0;
     Duration duration = 0;
 
     WaitRouteItem() = default;
@@ -217,6 +252,7 @@ struct WaitRouteItem {
 
     void Clear() {
         stop.clear();
+        stop_id = 0;
         duration = 0;
     }
     bool Empty(){
@@ -227,6 +263,10 @@ struct WaitRouteItem {
 
 using TransportRouteItems = std::vector<std::variant<std::monostate, WaitRouteItem, BusRouteItem>>;
 using GraphRouteInfo = graph::Router<EdgeWeight>::RouteInfo;
+// Маршрут: шаги и полная длительность, nullopt - маршрут не найден
+using TransportRouteInfo = std::optional<std::pair<TransportRouteItems, Duration>>;
+// Запрос маршрута: остановка отправления и остановка назначения
+using RouteQuery = std::pair<std::string_view, std::string_view>;
 
 
 class TransportRouter {
@@ -235,13 +275,26 @@ private:
     std::unique_ptr<graph::Router<EdgeWeight>> router_;
     
 public:
-    TransportRouter(TransportGraphMaker&& graph_maker) 
+    // mode задает, считать ли пути между всеми остановками заранее (ALL_PAIRS) 
+    // или искать пути от остановки при запросе (SINGLE_SOURCE, для больших графов)
+    TransportRouter(TransportGraphMaker&& graph_maker, graph::RouterMode mode = graph::RouterMode::ALL_PAIRS) 
         : graph_maker_(std::move(graph_maker)) {
-        router_ = std::make_unique<graph::Router<EdgeWeight>>(graph_maker_.GetGraph());
+        router_ = std::make_unique<graph::Router<EdgeWeight>>(graph_maker_.GetGraph(), mode);
     }
 
     std::optional<std::pair<TransportRouteItems, Duration>> GetRouteInfo(std::string_view from_stop, std::string_view to_stop) const;
 
+    /*
+    Отвечает на группу запросов маршрутов, ответы идут в порядке запросов.
+    Запросы группируются по остановке отправления: для каждой из них пути ищутся один раз,
+    и по ним восстанавливаются ответы на все запросы группы. 
+    Если задан пул потоков, группы обрабатываются параллельно
+    */
+    std::vector<TransportRouteInfo> GetRoutesInfo(const std::vector<RouteQuery>& queries, parallel::ThreadPool* thread_pool = nullptr) const;
+
+    // Обновляет граф и маршрутизатор после изменения каталога
+    void OnCatalogueChanged(const transport::CatalogueChange& change);
+
 private:
 
     std::optional<GraphRouteInfo> FindFasterRoute(const std::vector<size_t>& from_stop_inds, const std::vector<size_t>& to_stop_inds) const {